@@ -0,0 +1,81 @@
+#include <cstring>
+#include <cstdint>
+#include "Arena.h"
+
+const size_t Arena::OBJECT_ALIGNMENT;
+
+Arena::Arena(size_t chunkSize) : usedChunks(0), current(nullptr), limit(nullptr), chunkSize(chunkSize),
+  allocated(0), reserved(0), cleanups(nullptr)
+{
+}
+
+Arena::~Arena()
+{
+  runCleanups();
+  for (size_t i = 0; i < chunks.size(); i++)
+    delete[] chunks[i].data;
+}
+
+void *Arena::allocate(size_t size, size_t alignment)
+{
+  uintptr_t p = (reinterpret_cast<uintptr_t>(current) + alignment - 1) & ~(alignment - 1);
+  if (current == nullptr || p + size > reinterpret_cast<uintptr_t>(limit))
+  {
+    newChunk(size + alignment);
+    p = (reinterpret_cast<uintptr_t>(current) + alignment - 1) & ~(alignment - 1);
+  }
+
+  current = reinterpret_cast<char *>(p + size);
+  allocated += size;
+  return reinterpret_cast<void *>(p);
+}
+
+const char *Arena::copy(const char *data, size_t length)
+{
+  char *p = static_cast<char *>(allocate(length + 1, 1));
+  memcpy(p, data, length);
+  p[length] = 0;
+  return p;
+}
+
+void Arena::reset()
+{
+  runCleanups();
+  usedChunks = 0;
+  current = limit = nullptr;
+  allocated = 0;
+}
+
+// takes the next kept chunk that is big enough, the ones skipped wait for the next reset
+void Arena::newChunk(size_t minSize)
+{
+  while (usedChunks < chunks.size())
+  {
+    Chunk &chunk = chunks[usedChunks++];
+    if (chunk.size >= minSize)
+    {
+      current = chunk.data;
+      limit = chunk.data + chunk.size;
+      return;
+    }
+  }
+
+  Chunk chunk;
+  chunk.size = (minSize > chunkSize) ? minSize : chunkSize;
+  chunk.data = new char[chunk.size];
+  chunks.push_back(chunk);
+  usedChunks = chunks.size();
+  reserved += chunk.size;
+  current = chunk.data;
+  limit = chunk.data + chunk.size;
+}
+
+void Arena::runCleanups()
+{
+  while (cleanups != nullptr)
+  {
+    Cleanup *cleanup = cleanups;
+    cleanups = cleanup->next;
+    cleanup->destroy(cleanup->object);
+  }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// bump allocator; memory is only given back all at once, when the arena is reset or dies.
+// A long running process can keep one arena per worker and reset it after every unit, the
+// chunks are then reused instead of going back to malloc
+class Arena
+{
+public:
+  static const size_t OBJECT_ALIGNMENT = 8;
+
+  explicit Arena(size_t chunkSize = 64 * 1024);
+  ~Arena();
+
+  void *allocate(size_t size, size_t alignment = sizeof(void *));
+  const char *copy(const char *data, size_t length); // adds a terminating \0
+
+  // object has to be made with new (arena); its destructor runs when the arena is reset
+  // or dies, latest owned first. Objects which own nothing can skip this
+  template <class T>
+  T *own(T *object)
+  {
+    Cleanup *cleanup = static_cast<Cleanup *>(allocate(sizeof(Cleanup)));
+    cleanup->destroy = &destroy<T>;
+    cleanup->object = object;
+    cleanup->next = cleanups;
+    cleanups = cleanup;
+    return object;
+  }
+
+  // destroys the owned objects and forgets everything allocated, keeping the chunks
+  void reset();
+
+  size_t bytesAllocated() const { return allocated; }
+  size_t bytesReserved() const { return reserved; }
+
+private:
+  Arena(const Arena &);
+  Arena &operator=(const Arena &);
+
+  struct Chunk
+  {
+    char *data;
+    size_t size;
+  };
+
+  struct Cleanup
+  {
+    void (*destroy)(void *object);
+    void *object;
+    Cleanup *next;
+  };
+
+  template <class T>
+  static void destroy(void *object) { static_cast<T *>(object)->~T(); }
+
+  void newChunk(size_t minSize);
+  void runCleanups();
+
+  std::vector<Chunk> chunks;
+  size_t usedChunks;   // chunks handed out since the last reset, the last of them is current
+  char *current;
+  char *limit;
+  size_t chunkSize;
+  size_t allocated;
+  size_t reserved;
+  Cleanup *cleanups;
+};
+
+inline void *operator new(size_t size, Arena &arena)
+{
+  return arena.allocate(size, Arena::OBJECT_ALIGNMENT);
+}
+
+// only called if a constructor throws, the memory goes with the arena
+inline void operator delete(void *, Arena &)
+{
+}
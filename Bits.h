@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace bits
+{
+  inline uint64_t load64(const char *p)
+  {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word)); // little endian: first byte lands in the low bits
+    return word;
+  }
+
+  inline unsigned countTrailingZeros(uint64_t x)
+  {
+#ifdef _MSC_VER
+    unsigned long index;
+    if (_BitScanForward(&index, static_cast<unsigned long>(x)))
+      return index;
+    _BitScanForward(&index, static_cast<unsigned long>(x >> 32));
+    return index + 32;
+#else
+    return __builtin_ctzll(x);
+#endif
+  }
+
+  // time stamp counter; where there is none, nanoseconds of the steady clock stand in for cycles
+  inline uint64_t readCycles()
+  {
+#if defined(_MSC_VER) || defined(__i386__) || defined(__x86_64__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  // x must not be 0
+  inline unsigned countLeadingZeros(uint64_t x)
+  {
+#ifdef _MSC_VER
+    unsigned long index;
+    if (_BitScanReverse(&index, static_cast<unsigned long>(x >> 32)))
+      return 31 - index;
+    _BitScanReverse(&index, static_cast<unsigned long>(x));
+    return 63 - index;
+#else
+    return __builtin_clzll(x);
+#endif
+  }
+
+  // low half of the 128-bit product, the high half goes to high
+  inline uint64_t multiplyFull(uint64_t a, uint64_t b, uint64_t &high)
+  {
+#if defined(_MSC_VER) && defined(_M_X64)
+    return _umul128(a, b, &high);
+#elif defined(__SIZEOF_INT128__)
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    high = static_cast<uint64_t>(product >> 64);
+    return static_cast<uint64_t>(product);
+#else
+    uint64_t aLow = a & 0xFFFFFFFF, aHigh = a >> 32;
+    uint64_t bLow = b & 0xFFFFFFFF, bHigh = b >> 32;
+    uint64_t low = aLow * bLow;
+    uint64_t middle1 = aHigh * bLow;
+    uint64_t middle2 = aLow * bHigh;
+    uint64_t carry = ((low >> 32) + (middle1 & 0xFFFFFFFF) + (middle2 & 0xFFFFFFFF)) >> 32;
+    high = aHigh * bHigh + (middle1 >> 32) + (middle2 >> 32) + carry;
+    return a * b;
+#endif
+  }
+
+  inline unsigned popCount(uint32_t x)
+  {
+#ifdef _MSC_VER
+    x = x - ((x >> 1) & 0x55555555); // __popcnt needs a POPCNT capable cpu, this doesn't
+    x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+    return (((x + (x >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+#else
+    return __builtin_popcount(x);
+#endif
+  }
+
+  // byte-wise helpers, each returns the high bit of every byte that satisfies the test
+  const uint64_t ONES = 0x0101010101010101ULL;
+  const uint64_t HIGHS = 0x8080808080808080ULL;
+
+  // m < byte < n, for 0 <= m < n <= 128; bytes with the high bit set never match
+  inline uint64_t bytesBetween(uint64_t x, unsigned m, unsigned n)
+  {
+    uint64_t low = x & (ONES * 127);
+    return (ONES * (127 + n) - low) & ~x & (low + ONES * (127 - m)) & HIGHS;
+  }
+
+  inline uint64_t bytesEqual(uint64_t x, unsigned char c)
+  {
+    uint64_t t = x ^ (ONES * c);
+    return ~(((t & (ONES * 127)) + ONES * 127) | t) & HIGHS;
+  }
+
+  // packs a byte mask into one bit per byte, bit i for byte i
+  inline uint32_t byteBits(uint64_t mask)
+  {
+    return static_cast<uint32_t>(((mask >> 7) * 0x0102040810204080ULL) >> 56);
+  }
+
+  // index of the first byte flagged in a byte mask
+  inline unsigned firstByte(uint64_t mask)
+  {
+    return countTrailingZeros(mask) >> 3;
+  }
+
+  // word-at-a-time string hash; the last partial word is zero padded
+  inline uint64_t hashStep(uint64_t h, uint64_t word)
+  {
+    h = (h ^ word) * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 32);
+  }
+
+  inline uint32_t hashFinish(uint64_t h, size_t length)
+  {
+    h ^= length;
+    h *= 0xFF51AFD7ED558CCDULL;
+    return static_cast<uint32_t>(h ^ (h >> 33));
+  }
+
+  inline uint32_t hashBytes(const char *p, size_t length)
+  {
+    uint64_t h = 0;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8)
+      h = hashStep(h, load64(p + i));
+    if (i < length)
+    {
+      uint64_t tail = 0;
+      memcpy(&tail, p + i, length - i);
+      h = hashStep(h, tail);
+    }
+    return hashFinish(h, length);
+  }
+
+  // the same walk kept to 64 bits, for keys that have to tell whole files apart
+  inline uint64_t hashBytes64(const char *p, size_t length, uint64_t seed)
+  {
+    uint64_t h = seed;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8)
+      h = hashStep(h, load64(p + i));
+    if (i < length)
+    {
+      uint64_t tail = 0;
+      memcpy(&tail, p + i, length - i);
+      h = hashStep(h, tail);
+    }
+    h ^= length;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    return h ^ (h >> 33);
+  }
+}
@@ -0,0 +1,554 @@
+#include <cstring>
+#include "CharScan.h"
+#include "Unicode.h"
+#include "Bits.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LEX_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LEX_SSE2
+#endif
+
+// the UTF-8 check has an AVX2 build on any x86 target, the rest of the file only where the
+// compiler may assume AVX2; findInvalidUtf8 takes it when the CPU turns out to have it
+#if defined(LEX_AVX2)
+#define LEX_AVX2_UTF8
+#define LEX_TARGET_AVX2
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LEX_AVX2_UTF8
+#define LEX_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#define LEX_AVX2_UTF8
+#define LEX_TARGET_AVX2
+#endif
+
+_LEX_BEGIN
+
+using namespace bits;
+
+// a block of text and a compare giving one bit per matching byte, bit i for byte i;
+// the skipping loops below are written once against these
+#if defined(LEX_AVX2)
+typedef __m256i Block;
+const size_t BLOCK_SIZE = 32;
+
+static inline Block loadBlock(const char *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+
+static inline uint32_t matchBlock(Block b, char c)
+{
+  return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(b, _mm256_set1_epi8(c))));
+}
+
+static inline uint32_t highBitsBlock(Block b) { return static_cast<uint32_t>(_mm256_movemask_epi8(b)); }
+#elif defined(LEX_SSE2)
+typedef __m128i Block;
+const size_t BLOCK_SIZE = 16;
+
+static inline Block loadBlock(const char *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+
+static inline uint32_t matchBlock(Block b, char c)
+{
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(b, _mm_set1_epi8(c))));
+}
+
+static inline uint32_t highBitsBlock(Block b) { return static_cast<uint32_t>(_mm_movemask_epi8(b)); }
+#else
+typedef uint64_t Block;
+const size_t BLOCK_SIZE = 8;
+
+static inline Block loadBlock(const char *p) { return load64(p); }
+
+static inline uint32_t matchBlock(Block b, char c)
+{
+  return byteBits(bytesEqual(b, static_cast<unsigned char>(c)));
+}
+
+static inline uint32_t highBitsBlock(Block b) { return byteBits(b & HIGHS); }
+#endif
+
+// [0-9A-Za-z_], letters are tested case-folded
+static inline uint64_t identifierBytes(uint64_t x)
+{
+  return bytesBetween(x, '0' - 1, '9' + 1) | bytesBetween(x | (ONES * 0x20), 'a' - 1, 'z' + 1) | bytesEqual(x, '_');
+}
+
+// the rest of an identifier from p on, where the ASCII scan met a byte above 0x7F: code
+// points are decoded one by one and looked up, and the name is hashed again as a whole.
+// A first code point that can't start a name, or bytes that aren't UTF-8, end the name
+static const char *scanUnicodeIdentifier(const char *begin, const char *p, const char *end, uint32_t &hash)
+{
+  while (p < end)
+  {
+    unsigned char c = static_cast<unsigned char>(*p);
+    if (c < 0x80)
+    {
+      if (!isIdentifierChar(*p))
+        break;
+      p++;
+      continue;
+    }
+
+    uint32_t codePoint;
+    size_t length = decodeUtf8(p, end, codePoint);
+    if (length == 0 || !(p == begin ? isXidStart(codePoint) : isXidContinue(codePoint)))
+      break;
+    p += length;
+  }
+
+  hash = hashBytes(begin, p - begin);
+  return p;
+}
+
+const char *scanIdentifier(const char *begin, const char *end, uint32_t &hash)
+{
+  const char *p = begin;
+  uint64_t h = 0;
+  uint64_t tail = 0;
+  unsigned n = 0;
+
+  while (p + 8 <= end)
+  {
+    uint64_t word = load64(p);
+    uint64_t stop = ~identifierBytes(word) & HIGHS;
+    if (stop)
+    {
+      n = firstByte(stop);
+      tail = word & ((1ULL << (n * 8)) - 1);
+      break;
+    }
+    h = hashStep(h, word);
+    p += 8;
+  }
+
+  if (p + 8 > end) // fewer than a word left, the sentinel ends the run
+  {
+    for (; isIdentifierChar(p[n]); n++)
+      tail |= static_cast<uint64_t>(static_cast<unsigned char>(p[n])) << (n * 8);
+  }
+
+  if (n)
+  {
+    h = hashStep(h, tail);
+    p += n;
+  }
+  if (p < end && static_cast<unsigned char>(*p) >= 0x80)
+    return scanUnicodeIdentifier(begin, p, end, hash);
+  hash = hashFinish(h, p - begin);
+  return p;
+}
+
+const char *scanStringBody(const char *p, const char *end, bool &hasEscapes)
+{
+  while (true)
+  {
+    while (p + 8 <= end)
+    {
+      uint64_t word = load64(p);
+      uint64_t found = bytesEqual(word, '"') | bytesEqual(word, '\\') | bytesEqual(word, 0);
+      if (found)
+      {
+        p += firstByte(found);
+        break;
+      }
+      p += 8;
+    }
+
+    while (*p != '"' && *p != '\\' && *p != 0)
+      p++;
+
+    if (*p != '\\')
+      return p;
+
+    hasEscapes = true;
+    if (p[1] == 0)
+      return p + 1;
+    p += 2;
+  }
+}
+
+const char *skipBlanks(const char *p, const char *end)
+{
+  const uint32_t full = static_cast<uint32_t>((1ULL << BLOCK_SIZE) - 1);
+  while (p + BLOCK_SIZE <= end)
+  {
+    Block b = loadBlock(p);
+    uint32_t other = ~(matchBlock(b, '\n') | matchBlock(b, ' ') | matchBlock(b, '\t') | matchBlock(b, '\r')) & full;
+    if (other)
+      return p + countTrailingZeros(other);
+    p += BLOCK_SIZE;
+  }
+
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+    p++;
+  return p;
+}
+
+const char *findLineEnd(const char *p, const char *end)
+{
+  while (p + BLOCK_SIZE <= end)
+  {
+    uint32_t newlines = matchBlock(loadBlock(p), '\n');
+    if (newlines)
+      return p + countTrailingZeros(newlines);
+    p += BLOCK_SIZE;
+  }
+
+  while (p < end && *p != '\n')
+    p++;
+  return p;
+}
+
+const char *skipBlockComment(const char *p, const char *end)
+{
+  while (p + BLOCK_SIZE <= end)
+  {
+    uint32_t stars = matchBlock(loadBlock(p), '*');
+    if (!stars)
+    {
+      p += BLOCK_SIZE;
+      continue;
+    }
+
+    p += countTrailingZeros(stars) + 1;
+    if (p < end && *p == '/')
+      return p + 1;
+  }
+
+  for (; p < end; p++)
+  {
+    if (*p == '*' && p + 1 < end && p[1] == '/')
+      return p + 2;
+  }
+  return end;
+}
+
+void findLineStarts(const char *text, size_t length, std::vector<uint32_t> &starts)
+{
+  const char *p = text;
+  const char *end = text + length;
+  while (p + BLOCK_SIZE <= end)
+  {
+    uint32_t newlines = matchBlock(loadBlock(p), '\n');
+    for (; newlines; newlines &= newlines - 1)
+      starts.push_back(static_cast<uint32_t>(p - text + countTrailingZeros(newlines) + 1));
+    p += BLOCK_SIZE;
+  }
+
+  for (; p < end; p++)
+  {
+    if (*p == '\n')
+      starts.push_back(static_cast<uint32_t>(p - text + 1));
+  }
+}
+
+const char *findBlank(const char *p, const char *end)
+{
+  while (p + BLOCK_SIZE <= end)
+  {
+    Block b = loadBlock(p);
+    uint32_t blanks = matchBlock(b, ' ') | matchBlock(b, '\t') | matchBlock(b, '\r') | matchBlock(b, '\n');
+    if (blanks)
+      return p + countTrailingZeros(blanks);
+    p += BLOCK_SIZE;
+  }
+
+  while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+    p++;
+  return p;
+}
+
+const char *findCommentOrLiteral(const char *p, const char *end)
+{
+  while (p + BLOCK_SIZE <= end)
+  {
+    Block b = loadBlock(p);
+    uint32_t found = matchBlock(b, '/') | matchBlock(b, '"') | matchBlock(b, 0);
+    if (found)
+      return p + countTrailingZeros(found);
+    p += BLOCK_SIZE;
+  }
+
+  while (p < end && *p != '/' && *p != '"' && *p != 0)
+    p++;
+  return p;
+}
+
+#if defined(LEX_AVX2_UTF8)
+// decodes from p on and returns the first sequence that isn't UTF-8, or end
+static const char *findInvalidUtf8Scalar(const char *p, const char *end)
+{
+  while (p < end)
+  {
+    if (static_cast<unsigned char>(*p) < 0x80)
+    {
+      p++;
+      continue;
+    }
+    uint32_t codePoint;
+    size_t length = decodeUtf8(p, end, codePoint);
+    if (length == 0)
+      return p;
+    p += length;
+  }
+  return end;
+}
+
+// the lookup algorithm of Keiser and Lemire. Three tables indexed by the high and low nibble
+// of each byte and the high nibble of the byte after it give a bit per kind of error two
+// adjacent bytes may show; what is left over is the third and fourth bytes of long
+// sequences, which must be continuations exactly where a lead two or three bytes back says so
+enum Utf8Error
+{
+  TOO_SHORT = 1 << 0,     // a lead or ASCII byte where a continuation is due
+  TOO_LONG = 1 << 1,      // a continuation after ASCII
+  OVERLONG_3 = 1 << 2,
+  TOO_LARGE = 1 << 3,     // above U+10FFFF
+  SURROGATE = 1 << 4,
+  OVERLONG_2 = 1 << 5,
+  TOO_LARGE_1000 = 1 << 6,
+  OVERLONG_4 = 1 << 6,
+  TWO_CONTS = 1 << 7,     // two continuations, fine only as the third or fourth byte
+  CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS
+};
+
+LEX_TARGET_AVX2 static inline __m256i lookupNibbles(__m256i nibbles, __m256i table)
+{
+  return _mm256_shuffle_epi8(table, nibbles);
+}
+
+LEX_TARGET_AVX2 static inline __m256i makeTable(char b0, char b1, char b2, char b3, char b4, char b5, char b6, char b7,
+  char b8, char b9, char b10, char b11, char b12, char b13, char b14, char b15)
+{
+  return _mm256_setr_epi8(b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10, b11, b12, b13, b14, b15,
+    b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10, b11, b12, b13, b14, b15);
+}
+
+// the block shifted by n bytes towards the end, with the last n bytes of previous in front
+LEX_TARGET_AVX2 static inline __m256i previousBytes1(__m256i block, __m256i previous)
+{
+  return _mm256_alignr_epi8(block, _mm256_permute2x128_si256(previous, block, 0x21), 15);
+}
+
+LEX_TARGET_AVX2 static inline __m256i previousBytes2(__m256i block, __m256i previous)
+{
+  return _mm256_alignr_epi8(block, _mm256_permute2x128_si256(previous, block, 0x21), 14);
+}
+
+LEX_TARGET_AVX2 static inline __m256i previousBytes3(__m256i block, __m256i previous)
+{
+  return _mm256_alignr_epi8(block, _mm256_permute2x128_si256(previous, block, 0x21), 13);
+}
+
+// nonzero bytes where block has an error, given the block before it
+LEX_TARGET_AVX2 static inline __m256i checkUtf8Block(__m256i block, __m256i previous)
+{
+  const __m256i lowNibble = _mm256_set1_epi8(0x0F);
+  const char c = static_cast<char>(CARRY);
+  const char large = static_cast<char>(TOO_LARGE | TOO_LARGE_1000);
+  const char tooLarge = static_cast<char>(TOO_LARGE);
+
+  const __m256i byte1HighTable = makeTable(TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    static_cast<char>(TWO_CONTS), static_cast<char>(TWO_CONTS), static_cast<char>(TWO_CONTS), static_cast<char>(TWO_CONTS),
+    TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE, TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+  const __m256i byte1LowTable = makeTable(c | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, c | OVERLONG_2, c, c,
+    c | tooLarge, c | large, c | large, c | large, c | large, c | large, c | large, c | large,
+    c | large, c | large | SURROGATE, c | large, c | large);
+  const char continuation = static_cast<char>(TOO_LONG | OVERLONG_2 | TWO_CONTS);
+  const __m256i byte2HighTable = makeTable(TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    continuation | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4, continuation | OVERLONG_3 | TOO_LARGE,
+    continuation | SURROGATE | TOO_LARGE, continuation | SURROGATE | TOO_LARGE,
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+  __m256i previous1 = previousBytes1(block, previous);
+  __m256i byte1High = lookupNibbles(_mm256_and_si256(_mm256_srli_epi16(previous1, 4), lowNibble), byte1HighTable);
+  __m256i byte1Low = lookupNibbles(_mm256_and_si256(previous1, lowNibble), byte1LowTable);
+  __m256i byte2High = lookupNibbles(_mm256_and_si256(_mm256_srli_epi16(block, 4), lowNibble), byte2HighTable);
+  __m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+  // only a lead of 111xxxxx two bytes back or 1111xxxx three back keeps its top bit
+  __m256i third = _mm256_subs_epu8(previousBytes2(block, previous), _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+  __m256i fourth = _mm256_subs_epu8(previousBytes3(block, previous), _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+  __m256i mustContinue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+  return _mm256_xor_si256(mustContinue, special);
+}
+
+// nonzero if the block ends inside a sequence: a lead in its last three bytes that asks
+// for more bytes than are left
+LEX_TARGET_AVX2 static inline __m256i isIncomplete(__m256i block)
+{
+  const __m256i limits = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+  return _mm256_subs_epu8(block, limits);
+}
+
+LEX_TARGET_AVX2 const char *findInvalidUtf8Avx2(const char *p, const char *end)
+{
+  const size_t UTF8_BLOCK_SIZE = 32;
+  const char *begin = p;
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i previous = zero;
+  __m256i incomplete = zero;
+  char last[UTF8_BLOCK_SIZE];
+
+  while (p < end)
+  {
+    __m256i block;
+    if (p + UTF8_BLOCK_SIZE <= end)
+      block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    else
+    {
+      // the short tail is padded with ASCII, which can't hide an error
+      memset(last, 0, UTF8_BLOCK_SIZE);
+      memcpy(last, p, end - p);
+      block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(last));
+    }
+
+    // a sequence left open by the previous block is checked along with this one, unless
+    // this one is all ASCII and so certainly doesn't finish it
+    __m256i error;
+    if (_mm256_movemask_epi8(block) != 0)
+    {
+      error = checkUtf8Block(block, previous);
+      incomplete = isIncomplete(block);
+    }
+    else
+    {
+      error = incomplete;
+      incomplete = zero;
+    }
+
+    if (!_mm256_testz_si256(error, error))
+    {
+      // a sequence begun up to three bytes back of this block may be the one that's wrong;
+      // what comes before p is otherwise valid, so the first byte there that isn't a
+      // continuation starts a sequence
+      const char *from = (p - begin > 3) ? p - 3 : begin;
+      while (from < p && (static_cast<unsigned char>(*from) & 0xC0) == 0x80)
+        from++;
+      return findInvalidUtf8Scalar(from, end);
+    }
+
+    previous = block;
+    p += UTF8_BLOCK_SIZE;
+  }
+
+  if (!_mm256_testz_si256(incomplete, incomplete))
+  {
+    // the text ends inside a sequence; its lead is in the last three bytes
+    const char *from = (end - begin > 3) ? end - 3 : begin;
+    while (from < end && (static_cast<unsigned char>(*from) & 0xC0) == 0x80)
+      from++;
+    return findInvalidUtf8Scalar(from, end);
+  }
+  return end;
+}
+
+// AVX2 in the CPU and YMM registers saved by the operating system
+bool hasAvx2Utf8()
+{
+#if defined(LEX_AVX2)
+  return true;
+#elif defined(__GNUC__)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#else
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  __cpuid(info, 1);
+  const int OSXSAVE = 1 << 27;
+  const int AVX = 1 << 28;
+  if ((info[2] & (OSXSAVE | AVX)) != (OSXSAVE | AVX) || (_xgetbv(0) & 6) != 6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#endif
+}
+#else
+bool hasAvx2Utf8()
+{
+  return false;
+}
+
+const char *findInvalidUtf8Avx2(const char *p, const char *end)
+{
+  return findInvalidUtf8Blocks(p, end);
+}
+#endif
+
+// blocks of ASCII, the usual case, are passed over a block at a time and the rest decoded
+const char *findInvalidUtf8Blocks(const char *p, const char *end)
+{
+  while (p < end)
+  {
+    while (p + BLOCK_SIZE <= end && highBitsBlock(loadBlock(p)) == 0)
+      p += BLOCK_SIZE;
+
+    const char *runEnd = p + BLOCK_SIZE < end ? p + BLOCK_SIZE : end;
+    while (p < runEnd)
+    {
+      if (static_cast<unsigned char>(*p) < 0x80)
+      {
+        p++;
+        continue;
+      }
+      uint32_t codePoint;
+      size_t length = decodeUtf8(p, end, codePoint);
+      if (length == 0)
+        return p;
+      p += length;
+    }
+  }
+  return end;
+}
+
+const char *findInvalidUtf8(const char *p, const char *end)
+{
+#if defined(LEX_AVX2_UTF8)
+  static const bool avx2 = hasAvx2Utf8();
+  if (avx2)
+    return findInvalidUtf8Avx2(p, end);
+#endif
+  return findInvalidUtf8Blocks(p, end);
+}
+
+size_t decodeEscapes(const char *text, size_t length, char *out)
+{
+  char *start = out;
+  for (size_t i = 0; i < length; i++)
+  {
+    char c = text[i];
+    if (c == '\\' && i + 1 < length)
+    {
+      switch (text[++i])
+      {
+      case 'n':
+        c = '\n';
+        break;
+      case 't':
+        c = '\t';
+        break;
+      case 'r':
+        c = '\r';
+        break;
+      case '0':
+        c = 0;
+        break;
+      default: // \\, \" and anything unknown stand for themselves
+        c = text[i];
+        break;
+      }
+    }
+    *out++ = c;
+  }
+  return out - start;
+}
+
+_LEX_END
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Token.h"
+
+_LEX_BEGIN
+
+inline bool isDecimalDigit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+inline bool isIdentifierChar(char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// returns the first position at or after begin which can't continue an identifier and
+// hashes the skipped bytes the way bits::hashBytes does; whole words are only read
+// below end, the rest relies on the \0 sentinel at end. ASCII names never leave the word
+// loop, a byte above 0x7F goes on code point by code point with the XID properties;
+// begin itself comes back if the first code point can't start a name
+const char *scanIdentifier(const char *begin, const char *end, uint32_t &hash);
+
+// finds the closing quote of a literal whose body starts at p; stops at \0 instead
+// when the literal is unterminated, so the caller checks which one it got
+const char *scanStringBody(const char *p, const char *end, bool &hasEscapes);
+
+// skips spaces, tabs and line breaks below end
+const char *skipBlanks(const char *p, const char *end);
+
+// the first \n at or after p, or end when the line runs to the end of the text
+const char *findLineEnd(const char *p, const char *end);
+
+// p is just past the opening /*; returns the position after the closing */, or end if
+// the comment is never closed
+const char *skipBlockComment(const char *p, const char *end);
+
+// appends the offset of every byte that follows a \n in [text, text + length)
+void findLineStarts(const char *text, size_t length, std::vector<uint32_t> &starts);
+
+// the first space, tab or line break at or after p, or end
+const char *findBlank(const char *p, const char *end);
+
+// the first byte at or after p that may open a comment or a literal or stop the text:
+// a slash, a double quote or \0; end when there is none
+const char *findCommentOrLiteral(const char *p, const char *end);
+
+// the first byte of the first sequence in [p, end) that isn't well-formed UTF-8, or end;
+// a block of bytes at a time, all of them checked at once when the CPU has AVX2 and the
+// ASCII ones only elsewhere
+const char *findInvalidUtf8(const char *p, const char *end);
+
+// the two checks findInvalidUtf8 picks from, so tests can hold them against each other;
+// the AVX2 one may only be called when hasAvx2Utf8() is true
+bool hasAvx2Utf8();
+const char *findInvalidUtf8Avx2(const char *p, const char *end);
+const char *findInvalidUtf8Blocks(const char *p, const char *end);
+
+// writes the decoded text to out, which needs room for length chars; returns the decoded length
+size_t decodeEscapes(const char *text, size_t length, char *out);
+
+_LEX_END
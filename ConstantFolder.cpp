@@ -0,0 +1,363 @@
+#include <climits>
+#include "ConstantFolder.h"
+
+_LEX_BEGIN
+
+namespace
+{
+  // numeric types in the order a mixed operation widens to
+  enum NumericRank
+  {
+    RANK_INT,
+    RANK_FLOAT,
+    RANK_DOUBLE,
+    RANK_NONE
+  };
+
+  NumericRank getRank(const ConstantValue &value)
+  {
+    if (value.type == INTEGER)
+      return RANK_INT;
+    if (value.type == FLOAT)
+      return (value.subtype == Float::DOUBLE) ? RANK_DOUBLE : RANK_FLOAT;
+    return RANK_NONE;
+  }
+
+  // only asked of operands ranked no wider than float
+  float toFloat(const ConstantValue &value)
+  {
+    return (value.type == INTEGER) ? static_cast<float>(value.value.intValue) : value.value.floatValue;
+  }
+
+  double toDouble(const ConstantValue &value)
+  {
+    if (value.type == INTEGER)
+      return value.value.intValue;
+    return (value.subtype == Float::DOUBLE) ? value.value.doubleValue : value.value.floatValue;
+  }
+
+  ConstantValue makeValue(TokenType type, int subtype)
+  {
+    ConstantValue result;
+    result.type = type;
+    result.subtype = subtype;
+    result.value.symbol.index = 0;
+    result.value.symbol.scope = 0;
+    return result;
+  }
+
+  ConstantValue makeInt(int value)
+  {
+    ConstantValue result = makeValue(INTEGER, 10);
+    result.value.intValue = value;
+    return result;
+  }
+
+  ConstantValue makeFloat(float value)
+  {
+    ConstantValue result = makeValue(FLOAT, Float::SINGLE);
+    result.value.floatValue = value;
+    return result;
+  }
+
+  ConstantValue makeDouble(double value)
+  {
+    ConstantValue result = makeValue(FLOAT, Float::DOUBLE);
+    result.value.doubleValue = value;
+    return result;
+  }
+
+  ConstantValue makeBool(bool value)
+  {
+    ConstantValue result = makeValue(BOOL, 0);
+    result.value.boolValue = value;
+    return result;
+  }
+
+  // done in unsigned so that wrapping around is defined, two's complement gives the int back
+  int wrap(uint32_t value)
+  {
+    return static_cast<int>(value);
+  }
+
+  FoldStatus intArithmetic(int op, int a, int b, int &result)
+  {
+    uint32_t x = static_cast<uint32_t>(a);
+    uint32_t y = static_cast<uint32_t>(b);
+    switch (op)
+    {
+    case Arithmetic::PLUS:
+      result = wrap(x + y);
+      return FOLD_OK;
+    case Arithmetic::MINUS:
+      result = wrap(x - y);
+      return FOLD_OK;
+    case Arithmetic::MUL:
+      result = wrap(x * y);
+      return FOLD_OK;
+    case Arithmetic::DIV:
+    case Arithmetic::MOD:
+      if (b == 0)
+        return FOLD_DIVISION_BY_ZERO;
+      if (a == INT_MIN && b == -1) // the one quotient that doesn't fit, it wraps like the others
+        result = (op == Arithmetic::DIV) ? INT_MIN : 0;
+      else
+        result = (op == Arithmetic::DIV) ? a / b : a % b;
+      return FOLD_OK;
+    default:
+      return FOLD_SKIPPED;
+    }
+  }
+
+  template <class T>
+  FoldStatus floatArithmetic(int op, T a, T b, T &result)
+  {
+    switch (op)
+    {
+    case Arithmetic::PLUS:
+      result = a + b;
+      return FOLD_OK;
+    case Arithmetic::MINUS:
+      result = a - b;
+      return FOLD_OK;
+    case Arithmetic::MUL:
+      result = a * b;
+      return FOLD_OK;
+    case Arithmetic::DIV:
+      if (b == 0)
+        return FOLD_DIVISION_BY_ZERO;
+      result = a / b;
+      return FOLD_OK;
+    default:
+      return FOLD_SKIPPED;
+    }
+  }
+
+  bool isDivision(const TokenRef &op)
+  {
+    return op.getType() == ARITHMETIC && (op.getSubtype() == Arithmetic::DIV || op.getSubtype() == Arithmetic::MOD);
+  }
+
+  bool isZero(const ConstantValue &value)
+  {
+    return getRank(value) != RANK_NONE && toDouble(value) == 0;
+  }
+
+  template <class T>
+  bool compare(int op, T a, T b)
+  {
+    switch (op)
+    {
+    case Comparison::LESS:
+      return a < b;
+    case Comparison::LEQ:
+      return a <= b;
+    case Comparison::GRE:
+      return a > b;
+    case Comparison::GREQ:
+      return a >= b;
+    case Comparison::EQ:
+      return a == b;
+    default:
+      return a != b;
+    }
+  }
+}
+
+ConstantFolder::ConstantFolder(const TokenView &tokens) : tokens(tokens), folded(0), errorToken(0), error(nullptr)
+{
+}
+
+// children are always added to the tree before their parent, so one pass in the order of
+// the nodes folds the innermost expressions first and each parent finds its operands folded
+bool ConstantFolder::fold(Syntax &tree)
+{
+  folded = 0;
+  errorToken = 0;
+  error = nullptr;
+
+  for (NodeIndex i = 0; i < tree.size(); i++)
+  {
+    NodeKind kind = tree.getKind(i);
+    if (kind != NODE_UNARY && kind != NODE_BINARY)
+      continue;
+
+    const SyntaxNode &node = tree[i];
+    size_t opToken = node.token;
+    ConstantValue left;
+    ConstantValue right;
+    bool hasLeft = getConstant(tree, node.child[0], left);
+    bool hasRight = kind == NODE_BINARY && getConstant(tree, node.child[1], right);
+
+    ConstantValue result;
+    FoldStatus status;
+    if (kind == NODE_UNARY)
+      status = hasLeft ? foldUnary(tokens[opToken], left, result) : FOLD_SKIPPED;
+    else if (hasLeft && hasRight)
+      status = foldBinary(tokens[opToken], left, right, result);
+    else // a zero divisor is an error whatever it divides
+      status = (hasRight && isDivision(tokens[opToken]) && isZero(right)) ? FOLD_DIVISION_BY_ZERO : FOLD_SKIPPED;
+
+    if (status == FOLD_DIVISION_BY_ZERO)
+    {
+      error = "division by zero";
+      errorToken = opToken;
+      return false;
+    }
+    if (status == FOLD_OK)
+    {
+      tree.setValue(i, result);
+      folded++;
+    }
+  }
+  return true;
+}
+
+bool ConstantFolder::getConstant(const Syntax &tree, NodeIndex node, ConstantValue &value) const
+{
+  if (tree.getKind(node) == NODE_VALUE)
+  {
+    value = tree.getValue(node);
+    return true;
+  }
+  if (tree.getKind(node) != NODE_CONSTANT)
+    return false;
+
+  TokenRef token = tokens[tree[node].token];
+  switch (token.getType())
+  {
+  case INTEGER:
+    value = makeInt(token.getInt());
+    return true;
+  case FLOAT:
+    value = (token.getSubtype() == Float::DOUBLE) ? makeDouble(token.getDouble()) : makeFloat(token.getFloat());
+    return true;
+  case BOOL:
+    value = makeBool(token.getBool());
+    return true;
+  default: // strings don't take part in any operator
+    return false;
+  }
+}
+
+FoldStatus ConstantFolder::foldUnary(const TokenRef &op, const ConstantValue &operand, ConstantValue &result) const
+{
+  switch (op.getType())
+  {
+  case ARITHMETIC: // the parser only makes + and - unary
+    {
+      bool negate = op.getSubtype() == Arithmetic::MINUS;
+      switch (getRank(operand))
+      {
+      case RANK_INT:
+        result = makeInt(negate ? wrap(0u - static_cast<uint32_t>(operand.value.intValue)) : operand.value.intValue);
+        return FOLD_OK;
+      case RANK_FLOAT:
+        result = makeFloat(negate ? -operand.value.floatValue : operand.value.floatValue);
+        return FOLD_OK;
+      case RANK_DOUBLE:
+        result = makeDouble(negate ? -operand.value.doubleValue : operand.value.doubleValue);
+        return FOLD_OK;
+      default:
+        return FOLD_SKIPPED;
+      }
+    }
+  case LOGIC_NOT:
+    if (operand.type != BOOL)
+      return FOLD_SKIPPED;
+    result = makeBool(!operand.value.boolValue);
+    return FOLD_OK;
+  case BITWISE_NOT:
+    if (operand.type != INTEGER)
+      return FOLD_SKIPPED;
+    result = makeInt(~operand.value.intValue);
+    return FOLD_OK;
+  default:
+    return FOLD_SKIPPED;
+  }
+}
+
+FoldStatus ConstantFolder::foldBinary(const TokenRef &op, const ConstantValue &left, const ConstantValue &right, ConstantValue &result) const
+{
+  int subtype = op.getSubtype();
+  NumericRank leftRank = getRank(left);
+  NumericRank rightRank = getRank(right);
+  NumericRank rank = (leftRank > rightRank) ? leftRank : rightRank;
+
+  switch (op.getType())
+  {
+  case ARITHMETIC:
+    {
+      FoldStatus status = FOLD_SKIPPED;
+      if (rank == RANK_INT)
+      {
+        int value;
+        if ((status = intArithmetic(subtype, left.value.intValue, right.value.intValue, value)) == FOLD_OK)
+          result = makeInt(value);
+      }
+      else if (rank == RANK_FLOAT)
+      {
+        float value;
+        if ((status = floatArithmetic(subtype, toFloat(left), toFloat(right), value)) == FOLD_OK)
+          result = makeFloat(value);
+      }
+      else if (rank == RANK_DOUBLE)
+      {
+        double value;
+        if ((status = floatArithmetic(subtype, toDouble(left), toDouble(right), value)) == FOLD_OK)
+          result = makeDouble(value);
+      }
+      return status;
+    }
+  case COMPARISON:
+    if (left.type == BOOL && right.type == BOOL)
+    {
+      if (subtype != Comparison::EQ && subtype != Comparison::NEQ)
+        return FOLD_SKIPPED;
+      result = makeBool(compare(subtype, left.value.boolValue, right.value.boolValue));
+      return FOLD_OK;
+    }
+    if (rank == RANK_INT)
+      result = makeBool(compare(subtype, left.value.intValue, right.value.intValue));
+    else if (rank == RANK_FLOAT)
+      result = makeBool(compare(subtype, toFloat(left), toFloat(right)));
+    else if (rank == RANK_DOUBLE)
+      result = makeBool(compare(subtype, toDouble(left), toDouble(right)));
+    else
+      return FOLD_SKIPPED;
+    return FOLD_OK;
+  case SHIFT:
+    {
+      if (left.type != INTEGER || right.type != INTEGER || right.value.intValue < 0 || right.value.intValue > 31)
+        return FOLD_SKIPPED;
+      int count = right.value.intValue;
+      if (subtype == Shift::LEFT)
+        result = makeInt(wrap(static_cast<uint32_t>(left.value.intValue) << count));
+      else // arithmetic, the sign is kept
+        result = makeInt(left.value.intValue < 0 ? ~(~left.value.intValue >> count) : left.value.intValue >> count);
+      return FOLD_OK;
+    }
+  case BITWISE_BINARY:
+    {
+      if (left.type != INTEGER || right.type != INTEGER)
+        return FOLD_SKIPPED;
+      int a = left.value.intValue;
+      int b = right.value.intValue;
+      result = makeInt(subtype == BitwiseBinary::AND ? (a & b) : subtype == BitwiseBinary::OR ? (a | b) : (a ^ b));
+      return FOLD_OK;
+    }
+  case LOGIC_BINARY:
+    {
+      if (left.type != BOOL || right.type != BOOL)
+        return FOLD_SKIPPED;
+      bool a = left.value.boolValue;
+      bool b = right.value.boolValue;
+      result = makeBool(subtype == LogicBinary::AND ? (a && b) : subtype == LogicBinary::OR ? (a || b) : (a != b));
+      return FOLD_OK;
+    }
+  default:
+    return FOLD_SKIPPED;
+  }
+}
+
+_LEX_END
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Syntax.h"
+#include "TokenStream.h"
+
+_LEX_BEGIN
+
+enum FoldStatus
+{
+  FOLD_OK,
+  FOLD_SKIPPED,          // an operand isn't a constant, or the operator doesn't take its type
+  FOLD_DIVISION_BY_ZERO
+};
+
+// replaces every unary and binary expression whose operands are integer, float or bool
+// constants by a single NODE_VALUE, so later passes meet one constant instead of a subtree.
+// A mixed operation is done in the wider type: int, then float, then double. Integers wrap
+// around in 32 bits; a shift by less than 0 or more than 31 and % on floats are left alone,
+// as is anything with a name, a call or a string in it
+class ConstantFolder
+{
+public:
+  explicit ConstantFolder(const TokenView &tokens);
+
+  // false on a division or remainder by a constant zero, the tree then holds what was
+  // folded up to it
+  bool fold(Syntax &tree);
+
+  size_t getFoldedCount() const { return folded; }    // operators folded away by the last fold
+  size_t getErrorToken() const { return errorToken; } // stream index of the operator
+  const char *getError() const { return error; }
+
+private:
+  ConstantFolder(const ConstantFolder &);
+  ConstantFolder &operator=(const ConstantFolder &);
+
+  TokenView tokens;
+  size_t folded;
+  size_t errorToken;
+  const char *error;
+
+  bool getConstant(const Syntax &tree, NodeIndex node, ConstantValue &value) const;
+  FoldStatus foldUnary(const TokenRef &op, const ConstantValue &operand, ConstantValue &result) const;
+  FoldStatus foldBinary(const TokenRef &op, const ConstantValue &left, const ConstantValue &right, ConstantValue &result) const;
+};
+
+_LEX_END
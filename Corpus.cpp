@@ -0,0 +1,278 @@
+#include <cstring>
+#include <vector>
+#include "Corpus.h"
+#include "Keywords.h"
+
+_LEX_BEGIN
+
+namespace
+{
+  const char *const mixNames[CORPUS_MIX_COUNT] = { "identifiers", "numbers", "strings", "comments", "nesting", "blend" };
+
+  const size_t NAME_POOL_SIZE = 1024;
+  const size_t MAX_NESTING = 64;
+
+  const char *const words[] = { "lexer", "token", "scope", "value", "begin", "of", "the", "buffer", "is", "not", "a", "name", "//", "/*", "\"x\"", "*", "0x1F" };
+
+  class CorpusWriter
+  {
+  public:
+    CorpusWriter(size_t size, uint32_t seed) : size(size), seed(seed ? seed : 1), depth(0)
+    {
+      text.reserve(size + 1024);
+      for (size_t i = 0; i < NAME_POOL_SIZE; i++)
+        names.push_back(makeName());
+    }
+
+    bool full() const { return text.size() >= size; }
+
+    void identifiers();
+    void numbers();
+    void strings();
+    void comments();
+    void nesting();
+
+    std::string finish();
+
+  private:
+    std::string text;
+    std::vector<std::string> names;
+    size_t size;
+    uint32_t seed;
+    size_t depth;
+
+    // xorshift32, so the corpus doesn't depend on the library's rand
+    uint32_t random()
+    {
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+      return seed;
+    }
+    size_t below(size_t n) { return random() % n; }
+
+    std::string makeName();
+    void indent() { text.append(2 * depth, ' '); }
+    void name() { text += names[below(names.size())]; }
+    void digits(const char *set, size_t count, size_t maxCount);
+    void number();
+    void open();
+    void close();
+  };
+
+  std::string CorpusWriter::makeName()
+  {
+    static const char first[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_";
+    static const char rest[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+
+    std::string name;
+    do
+    {
+      name.assign(1, first[below(sizeof(first) - 1)]);
+      for (size_t n = below(16); n > 0; n--)
+        name += rest[below(sizeof(rest) - 1)];
+    } while (classifyWord(name.c_str(), name.size()).type != IDENTIFIER);
+    return name;
+  }
+
+  void CorpusWriter::digits(const char *set, size_t count, size_t maxCount)
+  {
+    text += set[1 + below(count - 1)]; // no leading zero, it would make a prefix
+    for (size_t n = below(maxCount); n > 0; n--)
+      text += set[below(count)];
+  }
+
+  // every literal fits the 32 bits the lexer keeps
+  void CorpusWriter::number()
+  {
+    switch (below(7))
+    {
+    case 0:
+      digits("0123456789", 10, 8);
+      break;
+    case 1:
+      text += "0x";
+      digits("0123456789abcdefABCDEF", 22, 7);
+      break;
+    case 2:
+      text += "0o";
+      digits("01234567", 8, 9);
+      break;
+    case 3:
+      text += "0q";
+      digits("0123", 4, 15);
+      break;
+    case 4:
+      text += "0b";
+      digits("01", 2, 31);
+      break;
+    case 5:
+      digits("0123456789", 10, 5);
+      text += '.';
+      digits("0123456789", 10, 6);
+      break;
+    default:
+      {
+        // long mantissa and a signed exponent, small enough for a float
+        static const char *const exponents[] = { "e", "e-", "e+" };
+        static const char *const suffixes[] = { "", "f", "d" };
+        digits("0123456789", 10, 3);
+        text += '.';
+        digits("0123456789", 10, 17);
+        text += exponents[below(3)];
+        digits("0123456789", 10, 1);
+        text += suffixes[below(3)];
+      }
+      break;
+    }
+  }
+
+  void CorpusWriter::identifiers()
+  {
+    static const char *const operators[] = { " + ", " - ", " * ", " & ", " | ", " << ", " == " };
+
+    indent();
+    name();
+    text += " = ";
+    name();
+    for (size_t n = 1 + below(4); n > 0; n--)
+    {
+      text += operators[below(sizeof(operators) / sizeof(operators[0]))];
+      name();
+    }
+    text += " ;\n";
+  }
+
+  void CorpusWriter::numbers()
+  {
+    indent();
+    name();
+    text += " = ";
+    number();
+    for (size_t n = 1 + below(4); n > 0; n--)
+    {
+      text += below(2) ? " + " : " * ";
+      number();
+    }
+    text += " ;\n";
+  }
+
+  void CorpusWriter::strings()
+  {
+    static const char *const escapes[] = { "\\\"", "\\\\", "\\n", "\\t" };
+    static const char plain[] = "abcdefghijklmnopqrstuvwxyz ,.:;-+*/=()[]{}<>0123456789";
+
+    indent();
+    name();
+    text += " = \"";
+    for (size_t n = 40 + below(400); n > 0; n--)
+    {
+      if (below(32) == 0)
+        text += escapes[below(sizeof(escapes) / sizeof(escapes[0]))];
+      else
+        text += plain[below(sizeof(plain) - 1)];
+    }
+    text += "\" ;\n";
+  }
+
+  void CorpusWriter::comments()
+  {
+    static const size_t wordCount = sizeof(words) / sizeof(words[0]);
+
+    indent();
+    if (below(2))
+    {
+      text += "//";
+      for (size_t n = 2 + below(12); n > 0; n--)
+        (text += ' ') += words[below(wordCount)];
+      text += '\n';
+    }
+    else
+    {
+      text += "/*";
+      for (size_t n = 4 + below(40); n > 0; n--)
+        (text += below(8) ? ' ' : '\n') += words[below(wordCount)]; // a blank keeps * and / apart
+      text += " */\n";
+    }
+    identifiers();
+  }
+
+  void CorpusWriter::open()
+  {
+    indent();
+    text += "begin\n";
+    depth++;
+  }
+
+  void CorpusWriter::close()
+  {
+    depth--;
+    indent();
+    text += "end\n";
+  }
+
+  // a walk that keeps returning to deep levels rather than staying near the top
+  void CorpusWriter::nesting()
+  {
+    if (depth == 0 || (depth < MAX_NESTING && below(8) < 5))
+      open();
+    else
+      close();
+    identifiers();
+  }
+
+  std::string CorpusWriter::finish()
+  {
+    while (depth > 0)
+      close();
+    return text;
+  }
+}
+
+const char *getMixName(CorpusMix mix)
+{
+  return mixNames[mix];
+}
+
+bool findMix(const char *name, CorpusMix &mix)
+{
+  for (int i = 0; i < CORPUS_MIX_COUNT; i++)
+  {
+    if (!strcmp(name, mixNames[i]))
+    {
+      mix = static_cast<CorpusMix>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string generateCorpus(CorpusMix mix, size_t size, uint32_t seed)
+{
+  CorpusWriter writer(size, seed);
+  uint32_t pick = 0;
+  while (!writer.full())
+  {
+    switch (mix == MIX_BLEND ? static_cast<CorpusMix>(pick++ % MIX_BLEND) : mix)
+    {
+    case MIX_IDENTIFIERS:
+      writer.identifiers();
+      break;
+    case MIX_NUMBERS:
+      writer.numbers();
+      break;
+    case MIX_STRINGS:
+      writer.strings();
+      break;
+    case MIX_COMMENTS:
+      writer.comments();
+      break;
+    default:
+      writer.nesting();
+      break;
+    }
+  }
+  return writer.finish();
+}
+
+_LEX_END
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "Token.h"
+
+_LEX_BEGIN
+
+// what most of a generated corpus is made of
+enum CorpusMix
+{
+  MIX_IDENTIFIERS,  // assignments between many distinct names
+  MIX_NUMBERS,      // integer literals of every base and floats
+  MIX_STRINGS,      // long literals with escapes
+  MIX_COMMENTS,     // line and block comments around short statements
+  MIX_NESTING,      // begin/end blocks nested tens of levels deep
+  MIX_BLEND,        // all of the above in turn
+
+  CORPUS_MIX_COUNT
+};
+
+const char *getMixName(CorpusMix mix);
+bool findMix(const char *name, CorpusMix &mix);
+
+// source text of about size bytes which lexes without errors; the generator has its own
+// random numbers, so a mix, size and seed give the same text with every compiler
+std::string generateCorpus(CorpusMix mix, size_t size, uint32_t seed = 1);
+
+_LEX_END
@@ -0,0 +1,443 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include "IncrementalLexer.h"
+#include "CharScan.h"
+
+_LEX_BEGIN
+
+const size_t IncrementalLexer::MIN_SCAN_WINDOW;
+
+IncrementalLexer::IncrementalLexer() : text(1, 0), gapStart(0), gapEnd(1), length(0),
+  tokenGapStart(0), tokenGapEnd(0), tailDepthShift(0), visible(0), parked(0), parkedFloor(0), endDepthLeaves(0),
+  state(FINISHED)
+{
+  lexer.deferSymbols = true;
+  lexer.validateInput = false; // the whole text is checked once, every edit only for itself
+}
+
+bool IncrementalLexer::readFile(const char *fileName)
+{
+  SourceBuffer file;
+  if (!file.mapFile(fileName))
+  {
+    state = WRONG_FILE;
+    return false;
+  }
+
+  setText(file.data(), file.size());
+  return true;
+}
+
+void IncrementalLexer::setText(const char *data, size_t size)
+{
+  text.assign(data, data + size);
+  text.resize(size + std::max(size / 2, MIN_SCAN_WINDOW));
+  gapStart = size;
+  gapEnd = text.size();
+  length = size;
+
+  lexemes.clear();
+  depths.clear();
+  lexer.symbolNames.clear(); // no lexeme refers to a name any more
+  tokenGapStart = tokenGapEnd = 0;
+  tailDepthShift = 0;
+  visible = parked = 0;
+
+  if (findInvalidUtf8(data, data + size) != data + size)
+  {
+    state = WRONG_ENCODING;
+    return;
+  }
+
+  size_t keptVisible = 0;
+  int depth = 0;
+  state = PARSING;
+  bool synced = relex(0, depth, keptVisible);
+  finish(synced, keptVisible, depth, FINISHED);
+}
+
+const char *IncrementalLexer::getText()
+{
+  moveTextGap(length);
+  text[gapStart] = 0;
+  return &text[0];
+}
+
+Lexeme IncrementalLexer::getLexeme(size_t i) const
+{
+  Lexeme lexeme = lexemes[physical(i)];
+  lexeme.offset = static_cast<uint32_t>(getOffset(i));
+  return lexeme;
+}
+
+unsigned IncrementalLexer::getDepth(size_t i) const
+{
+  return (i < tokenGapStart) ? depths[i] : depths[physical(i)] + tailDepthShift;
+}
+
+const char *IncrementalLexer::getName(const Lexeme &identifier) const
+{
+  return lexer.symbolNames.getName(static_cast<uint32_t>(identifier.symbolIndex));
+}
+
+size_t IncrementalLexer::getOffset(size_t i) const
+{
+  return (i < tokenGapStart) ? lexemes[i].offset : length - lexemes[physical(i)].offset;
+}
+
+size_t IncrementalLexer::getEnd(size_t i) const
+{
+  return getOffset(i) + lexemes[physical(i)].length;
+}
+
+// the end of the text counts as a start, a continuation byte doesn't
+bool IncrementalLexer::isSequenceStart(size_t offset) const
+{
+  return offset == length || (static_cast<unsigned char>(at(offset)) & 0xC0) != 0x80;
+}
+
+int IncrementalLexer::depthAfter(size_t i) const
+{
+  const Lexeme &lexeme = lexemes[physical(i)];
+  int depth = getDepth(i);
+  if (lexeme.type == RESERVED && lexeme.subtype == ReservedWord::BEGIN)
+    return depth + 1;
+  if (lexeme.type == RESERVED && lexeme.subtype == ReservedWord::END)
+    return depth - 1;
+  return depth;
+}
+
+void IncrementalLexer::moveTextGap(size_t position)
+{
+  if (position < gapStart)
+  {
+    size_t n = gapStart - position;
+    memmove(&text[gapEnd - n], &text[position], n);
+    gapStart -= n;
+    gapEnd -= n;
+  }
+  else if (position > gapStart)
+  {
+    size_t n = position - gapStart;
+    memmove(&text[gapStart], &text[gapEnd], n);
+    gapStart += n;
+    gapEnd += n;
+  }
+}
+
+void IncrementalLexer::growTextGap(size_t size)
+{
+  size_t tail = text.size() - gapEnd;
+  std::vector<char> bigger(gapStart + tail + std::max(size, length));
+  std::copy(text.begin(), text.begin() + gapStart, bigger.begin());
+  std::copy(text.begin() + gapEnd, text.end(), bigger.end() - tail);
+  text.swap(bigger);
+  gapEnd = text.size() - tail;
+}
+
+// lexemes crossing the gap switch between offsets from the start and from the end of the text
+void IncrementalLexer::moveTokenGap(size_t index)
+{
+  while (tokenGapStart > index)
+  {
+    tokenGapStart--;
+    tokenGapEnd--;
+    lexemes[tokenGapEnd] = lexemes[tokenGapStart];
+    lexemes[tokenGapEnd].offset = static_cast<uint32_t>(length - lexemes[tokenGapEnd].offset);
+    depths[tokenGapEnd] = depths[tokenGapStart] - tailDepthShift;
+    setEndDepth(tokenGapEnd);
+  }
+  while (tokenGapStart < index)
+  {
+    lexemes[tokenGapStart] = lexemes[tokenGapEnd];
+    lexemes[tokenGapStart].offset = static_cast<uint32_t>(length - lexemes[tokenGapStart].offset);
+    depths[tokenGapStart] = depths[tokenGapEnd] + tailDepthShift;
+    tokenGapStart++;
+    tokenGapEnd++;
+  }
+}
+
+void IncrementalLexer::insertLexeme(const Lexeme &lexeme, int depth)
+{
+  if (tokenGapStart == tokenGapEnd)
+  {
+    size_t tail = lexemes.size() - tokenGapEnd;
+    size_t grown = std::max<size_t>(lexemes.size() * 2, 64);
+    lexemes.resize(grown);
+    depths.resize(grown);
+    std::copy_backward(lexemes.begin() + tokenGapEnd, lexemes.begin() + tokenGapEnd + tail, lexemes.end());
+    std::copy_backward(depths.begin() + tokenGapEnd, depths.begin() + tokenGapEnd + tail, depths.end());
+    tokenGapEnd = grown - tail;
+    rebuildEndDepths();
+  }
+
+  lexemes[tokenGapStart] = lexeme;
+  depths[tokenGapStart] = depth;
+  tokenGapStart++;
+  visible++;
+}
+
+// behind the gap come the visible lexemes kept from the last pass, then the parked ones
+void IncrementalLexer::dropBehindGap(size_t &keptVisible)
+{
+  tokenGapEnd++;
+  if (keptVisible)
+  {
+    keptVisible--;
+    visible--;
+  }
+  else
+    parked--;
+}
+
+void IncrementalLexer::setEndDepth(size_t p)
+{
+  const Lexeme &lexeme = lexemes[p];
+  size_t node = endDepthLeaves + p;
+  endDepths[node] = (lexeme.type == RESERVED && lexeme.subtype == ReservedWord::END) ? depths[p] : INT_MAX;
+  for (node /= 2; node; node /= 2)
+    endDepths[node] = std::min(endDepths[2 * node], endDepths[2 * node + 1]);
+}
+
+// after the lexemes were moved in memory as a whole
+void IncrementalLexer::rebuildEndDepths()
+{
+  endDepthLeaves = 1;
+  while (endDepthLeaves < lexemes.size())
+    endDepthLeaves *= 2;
+  endDepths.assign(2 * endDepthLeaves, INT_MAX);
+  for (size_t p = tokenGapEnd; p < lexemes.size(); p++)
+  {
+    const Lexeme &lexeme = lexemes[p];
+    if (lexeme.type == RESERVED && lexeme.subtype == ReservedWord::END)
+      endDepths[endDepthLeaves + p] = depths[p];
+  }
+  for (size_t node = endDepthLeaves - 1; node; node--)
+    endDepths[node] = std::min(endDepths[2 * node], endDepths[2 * node + 1]);
+}
+
+// physical index of the first end in [begin, end) with a stored depth of maxDepth or less,
+// or end; node covers [nodeBegin, nodeEnd)
+size_t IncrementalLexer::findEnd(size_t node, size_t nodeBegin, size_t nodeEnd, size_t begin, size_t end, int maxDepth) const
+{
+  if (nodeEnd <= begin || end <= nodeBegin || endDepths[node] > maxDepth)
+    return end;
+  if (node >= endDepthLeaves)
+    return nodeBegin;
+  size_t middle = (nodeBegin + nodeEnd) / 2;
+  size_t found = findEnd(2 * node, nodeBegin, middle, begin, end, maxDepth);
+  return (found != end) ? found : findEnd(2 * node + 1, middle, nodeEnd, begin, end, maxDepth);
+}
+
+// index of the first stored lexeme whose recognition looked at offset or anything after it
+size_t IncrementalLexer::firstAffected(size_t offset) const
+{
+  size_t low = 0;
+  size_t high = stored();
+  while (low < high)
+  {
+    size_t mid = (low + high) / 2;
+    if (getEnd(mid) + MAX_LOOKAHEAD > offset)
+      high = mid;
+    else
+      low = mid + 1;
+  }
+  return low;
+}
+
+// the lexer sees the text up to the gap only, so whenever it may have run into the gap the
+// gap is moved further out and the lexeme scanned again; the lexer leaves scopes alone in
+// this mode, so an end with nothing to close is caught here
+bool IncrementalLexer::scanFrom(size_t position, int depth, Lexeme &lexeme)
+{
+  // resume() starts where the visible lexemes end, which can lie behind the gap
+  if (position > gapStart)
+    moveTextGap(std::min(length, position + MIN_SCAN_WINDOW));
+
+  while (true)
+  {
+    text[gapStart] = 0;
+    lexer.source.assign(&text[0], gapStart);
+    lexer.onSourceLoaded();
+    lexer.setRange(position, gapStart);
+
+    bool found = lexer.scan(lexeme);
+    if (gapStart == length)
+      break;
+    if (found && lexeme.offset + lexeme.length + MAX_LOOKAHEAD <= gapStart)
+      break;
+    if (!found && lexer.state == FINISHED && lexer.currentIndex < gapStart) // stopped on a \0 in the text
+      break;
+
+    moveTextGap(std::min(length, gapStart + std::max(gapStart - std::min(position, gapStart), MIN_SCAN_WINDOW)));
+  }
+
+  if (lexer.state != PARSING)
+  {
+    state = lexer.state;
+    return false;
+  }
+  if (lexeme.type == RESERVED && lexeme.subtype == ReservedWord::END && depth == 0)
+  {
+    state = SYNTAX_ERROR;
+    return false;
+  }
+  return true;
+}
+
+// lexes from position into the gap; a stored lexeme behind the gap was lexed from a place
+// where the lexer sat between two lexemes with the same text ahead, so once a new lexeme
+// starts where a stored one does the rest can be kept. The ones passed over are dropped
+bool IncrementalLexer::relex(size_t position, int &depth, size_t &keptVisible)
+{
+  Lexeme lexeme;
+  while (scanFrom(position, depth, lexeme))
+  {
+    while (tokenGapEnd < lexemes.size() && length - lexemes[tokenGapEnd].offset < lexeme.offset)
+      dropBehindGap(keptVisible);
+    if (tokenGapEnd < lexemes.size() && length - lexemes[tokenGapEnd].offset == lexeme.offset)
+      return true;
+
+    insertLexeme(lexeme, depth);
+    position = lexeme.offset + lexeme.length;
+    depth = depthAfter(tokenGapStart - 1);
+  }
+  return false;
+}
+
+bool IncrementalLexer::finish(bool synced, size_t keptVisible, int depth, LexerState oldState)
+{
+  if (synced)
+  {
+    // the kept lexemes may sit under more or fewer begins now; kept visible ones had every
+    // end at depth 1 or more before the shift, parked ones no lower than parkedFloor
+    int shift = depth - (depths[tokenGapEnd] + tailDepthShift);
+    int floor = 1 - tailDepthShift;
+    tailDepthShift += shift;
+    bool mayUnderflow = shift < 0;
+    if (keptVisible == 0) // lined up with parked lexemes, which run on to the end of the text
+    {
+      floor = parkedFloor;
+      mayUnderflow = parkedFloor + tailDepthShift <= 0;
+      visible += parked;
+      parked = 0;
+      state = FINISHED;
+    }
+
+    if (mayUnderflow && !checkScopes(floor))
+      return false;
+    if (state != FINISHED) // the old pass stopped somewhere behind the kept lexemes
+      return resume();
+    return true;
+  }
+
+  if (state == FINISHED)
+  {
+    tokenGapEnd = lexemes.size();
+    visible = tokenGapStart;
+    parked = 0;
+    return true;
+  }
+
+  // an old lexeme overlapping the last new one can't be a place to line up at
+  size_t end = tokenGapStart ? lexemes[tokenGapStart - 1].offset + lexemes[tokenGapStart - 1].length : 0;
+  while (tokenGapEnd < lexemes.size() && length - lexemes[tokenGapEnd].offset < end)
+    dropBehindGap(keptVisible);
+
+  // kept lexemes can only be parked if nothing separates them from the ones already parked
+  if (oldState == FINISHED)
+  {
+    parked += keptVisible;
+    parkedFloor = 1 - tailDepthShift;
+  }
+  else
+    tokenGapEnd += keptVisible;
+  visible -= keptVisible;
+  return false;
+}
+
+// after an edit took away begins, a visible end may now close a scope that isn't there;
+// from there on the lexemes are parked. floor is the lowest stored depth of an end among them.
+// Depths change by one from lexeme to lexeme and start at 0 or more, so the first end at
+// depth 0 or less is at exactly 0
+bool IncrementalLexer::checkScopes(int floor)
+{
+  if (tokenGapStart == visible)
+    return true;
+  size_t visibleEnd = physical(visible);
+  size_t p = findEnd(1, 0, endDepthLeaves, tokenGapEnd, visibleEnd, -tailDepthShift);
+  if (p == visibleEnd)
+    return true;
+
+  // the rest can be parked if it runs on to the end of the text, but not if the old pass
+  // stopped on an error in between
+  size_t i = p - (tokenGapEnd - tokenGapStart);
+  if (state == FINISHED)
+  {
+    parked = visible - i;
+    parkedFloor = floor;
+  }
+  else
+  {
+    lexemes.resize(p);
+    depths.resize(p);
+    parked = 0;
+  }
+  visible = i;
+  state = SYNTAX_ERROR;
+  return false;
+}
+
+// lexes on from the last visible lexeme towards the parked ones
+bool IncrementalLexer::resume()
+{
+  moveTokenGap(visible);
+  size_t position = visible ? getEnd(visible - 1) : 0;
+  int depth = visible ? depthAfter(visible - 1) : 0;
+
+  size_t keptVisible = 0;
+  state = PARSING;
+  bool synced = relex(position, depth, keptVisible);
+  return finish(synced, keptVisible, depth, SYNTAX_ERROR);
+}
+
+bool IncrementalLexer::edit(size_t offset, size_t removed, const char *inserted, size_t insertedLength)
+{
+  if (offset > length || removed > length - offset || state == WRONG_ENCODING)
+    return false;
+  if (!isSequenceStart(offset) || !isSequenceStart(offset + removed)
+    || findInvalidUtf8(inserted, inserted + insertedLength) != inserted + insertedLength)
+    return false;
+
+  // lexing restarts where the last untouched visible lexeme ends, so comments opened or
+  // closed in the blanks before the edit are seen again
+  size_t first = std::min(firstAffected(offset), visible);
+  size_t position = first ? getEnd(first - 1) : 0;
+  int depth = first ? depthAfter(first - 1) : 0;
+  LexerState oldState = state;
+
+  moveTokenGap(first);
+  size_t keptVisible = visible - first;
+  while (tokenGapEnd < lexemes.size() && length - lexemes[tokenGapEnd].offset < offset + removed)
+    dropBehindGap(keptVisible);
+
+  moveTextGap(offset);
+  gapEnd += removed;
+  if (gapEnd - gapStart <= insertedLength)
+    growTextGap(insertedLength + 1);
+  std::copy(inserted, inserted + insertedLength, text.begin() + gapStart);
+  gapStart += insertedLength;
+  length = length - removed + insertedLength;
+
+  // what is left behind the gap starts after the edit and counts its offset from the end,
+  // so it is already right for the new text
+  state = PARSING;
+  bool synced = relex(position, depth, keptVisible);
+  if (synced)
+    state = oldState;
+  finish(synced, keptVisible, depth, oldState);
+  return true;
+}
+
+_LEX_END
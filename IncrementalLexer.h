@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include "Lexer.h"
+
+_LEX_BEGIN
+
+// keeps the lexemes of a text being edited and re-lexes only around each edit; the lexemes
+// are always those Lexer::tokenize would give for the current text, except that identifiers
+// carry their interned name id and scopes are given as a nesting depth per lexeme
+//
+// text and lexemes are both kept in gap buffers with the gap at the last edit, so an edit
+// costs the distance to the previous one plus the lexemes it touches; lexemes behind the gap
+// store their offset from the end of the text and need no update when the text before them
+// changes length. When lexing stops on an error the old lexemes past it are parked instead
+// of dropped, so the edit that fixes the error can line up with them again
+class IncrementalLexer
+{
+public:
+  IncrementalLexer();
+
+  bool readFile(const char *fileName);
+  // a text that isn't UTF-8 is kept without lexemes in WRONG_ENCODING, and no edit is taken
+  // until another text is set
+  void setText(const char *data, size_t length);
+
+  // replaces removed characters at offset with the inserted ones and re-lexes from the first
+  // lexeme the change can reach until the new lexemes line up with the old ones again. The
+  // text stays UTF-8: an edit whose inserted bytes aren't, or whose ends split a sequence,
+  // is refused with false and changes nothing. A taken edit returns true even if lexing now
+  // stops on an error, getState tells
+  bool edit(size_t offset, size_t removed, const char *inserted, size_t insertedLength);
+
+  const char *getText(); // closes the gap, so the text is \0 terminated in one piece
+  size_t getLength() const { return length; }
+
+  size_t size() const { return visible; }
+  Lexeme getLexeme(size_t i) const;
+  unsigned getDepth(size_t i) const; // begin/end pairs around the lexeme
+  const char *getName(const Lexeme &identifier) const;
+
+  LexerState getState() const { return state; }
+
+private:
+  IncrementalLexer(const IncrementalLexer &);
+  IncrementalLexer &operator=(const IncrementalLexer &);
+
+  static const size_t MIN_SCAN_WINDOW = 256;
+
+  std::vector<char> text;      // the gap is never empty, its first byte serves as \0 sentinel
+  size_t gapStart;
+  size_t gapEnd;
+  size_t length;
+
+  // the first visible lexemes are the result, the parked ones after them are what an earlier
+  // pass lexed from some point past the error up to the end of the text
+  std::vector<Lexeme> lexemes;
+  std::vector<int> depths;
+  size_t tokenGapStart;
+  size_t tokenGapEnd;
+  int tailDepthShift;          // added to the depth of every lexeme behind the gap
+  size_t visible;
+  size_t parked;
+  int parkedFloor;             // no parked end has a lower stored depth
+
+  // minimum tree over the stored depth of every end, by physical index, so the first end
+  // behind the gap that closes a scope which isn't there is found in logarithmic time; only
+  // the slots behind the gap are kept up to date and only they are ever searched
+  std::vector<int> endDepths;
+  size_t endDepthLeaves;
+
+  LexerState state;
+  Lexer lexer;                 // scans with deferred symbols, its interner keeps name ids stable
+
+  size_t physical(size_t i) const { return i < tokenGapStart ? i : i + (tokenGapEnd - tokenGapStart); }
+  char at(size_t offset) const { return text[offset < gapStart ? offset : offset + (gapEnd - gapStart)]; }
+  bool isSequenceStart(size_t offset) const;
+  size_t getOffset(size_t i) const;
+  size_t getEnd(size_t i) const;
+  int depthAfter(size_t i) const;
+  size_t stored() const { return lexemes.size() - (tokenGapEnd - tokenGapStart); }
+
+  void moveTextGap(size_t position);
+  void growTextGap(size_t size);
+  void moveTokenGap(size_t index);
+  void insertLexeme(const Lexeme &lexeme, int depth);
+  void dropBehindGap(size_t &keptVisible);
+  void setEndDepth(size_t p);
+  void rebuildEndDepths();
+  size_t findEnd(size_t node, size_t nodeBegin, size_t nodeEnd, size_t begin, size_t end, int maxDepth) const;
+
+  size_t firstAffected(size_t offset) const;
+  bool scanFrom(size_t position, int depth, Lexeme &lexeme);
+  bool relex(size_t position, int &depth, size_t &keptVisible);
+  bool finish(bool synced, size_t keptVisible, int depth, LexerState oldState);
+  bool checkScopes(int floor);
+  bool resume();
+};
+
+_LEX_END
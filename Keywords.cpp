@@ -0,0 +1,26 @@
+#include "Keywords.h"
+
+_LEX_BEGIN
+
+// laid out by keywordSlot, so the table is plain constant data with nothing to set up at run time
+const KeywordEntry keywordTable[KEYWORD_TABLE_SIZE] =
+{
+  { 0, "",      { IDENTIFIER, 0 } },
+  { 4, "true",  { BOOL, true } },
+  { 4, "else",  { RESERVED, ReservedWord::ELSE } },
+  { 3, "for",   { RESERVED, ReservedWord::FOR } },
+  { 5, "false", { BOOL, false } },
+  { 5, "while", { RESERVED, ReservedWord::WHILE } },
+  { 0, "",      { IDENTIFIER, 0 } },
+  { 4, "elif",  { RESERVED, ReservedWord::ELIF } },
+  { 0, "",      { IDENTIFIER, 0 } },
+  { 2, "if",    { RESERVED, ReservedWord::IF } },
+  { 0, "",      { IDENTIFIER, 0 } },
+  { 0, "",      { IDENTIFIER, 0 } },
+  { 3, "end",   { RESERVED, ReservedWord::END } },
+  { 5, "begin", { RESERVED, ReservedWord::BEGIN } },
+  { 0, "",      { IDENTIFIER, 0 } },
+  { 0, "",      { IDENTIFIER, 0 } },
+};
+
+_LEX_END
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstring>
+#include "Token.h"
+
+_LEX_BEGIN
+
+// what an identifier shaped word turns out to be
+struct KeywordInfo
+{
+  TokenType type;  // RESERVED, BOOL, or IDENTIFIER for any other name
+  int value;       // ReservedWord::ReservedType or the boolean value
+};
+
+struct KeywordEntry
+{
+  unsigned char length;  // 0 marks an unused slot
+  const char *text;
+  KeywordInfo info;
+};
+
+const size_t KEYWORD_TABLE_SIZE = 16;
+const size_t KEYWORD_MIN_LENGTH = 2;
+const size_t KEYWORD_MAX_LENGTH = 5;
+
+extern const KeywordEntry keywordTable[KEYWORD_TABLE_SIZE];
+
+// perfect over the keyword set: every keyword gets a slot of its own
+inline size_t keywordSlot(const char *word, size_t length)
+{
+  return (length + static_cast<unsigned char>(word[0]) + 5 * static_cast<unsigned char>(word[length - 1])) & (KEYWORD_TABLE_SIZE - 1);
+}
+
+inline KeywordInfo classifyWord(const char *word, size_t length)
+{
+  static const KeywordInfo notKeyword = { IDENTIFIER, 0 };
+
+  if (length < KEYWORD_MIN_LENGTH || length > KEYWORD_MAX_LENGTH)
+    return notKeyword;
+
+  const KeywordEntry &e = keywordTable[keywordSlot(word, length)];
+  if (e.length != length || e.text[0] != word[0] || memcmp(e.text + 1, word + 1, length - 1))
+    return notKeyword;
+  return e.info;
+}
+
+_LEX_END
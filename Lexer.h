@@ -1,44 +1,157 @@
 #pragma once
 
-#include <fstream>
+#include <string>
+#include <map>
 #include <vector>
 #include "Token.h"
 #include "SymbolTable.h"
+#include "Scanner.h"
+#include "TokenStream.h"
+#include "SourceBuffer.h"
+#include "Keywords.h"
+#include "Numbers.h"
+#include "LexerStats.h"
+#include "LexerTrace.h"
+#include "LineIndex.h"
+
+// the trace policy the lexer is built with; a profiling build defines it to ChromeTrace
+#ifndef LEX_TRACE_POLICY
+#define LEX_TRACE_POLICY NullTrace
+#endif
 
 _LEX_BEGIN
 
+typedef LEX_TRACE_POLICY TracePolicy;
+
+// changes whenever the same text may give other tokens or symbols, so cached tokens made
+// by an older lexer are never taken for current ones
+const uint32_t LEXER_VERSION = 2;
+
 enum LexerState
 {
   PARSING,
   WRONG_FILE,
   SYNTAX_ERROR,
+  CONSTANT_OVERFLOW,
+  WRONG_ENCODING,   // the text isn't UTF-8, getOffset is the first byte that breaks it
   FINISHED
 };
 
+// what a call of Lexer::getNextTokens ended with
+enum BatchStatus
+{
+  BATCH_OK,     // the buffer is full, more tokens may follow
+  BATCH_END,    // the input is used up
+  BATCH_ERROR   // lexing stopped, getState tells why
+};
+
+enum LexerEngine
+{
+  TABLE_DRIVEN,     // single pass over the scanner automaton
+  MATCHER_CASCADE   // original getXxxToken chain, kept to diff against
+};
+
 class Lexer;
-struct LexemeStart;
+class ParallelLexer;
+class IncrementalLexer;
+class TokenRing;
 struct TokenData;
 
+// where the matchers of the cascade started, so a failed one can back off
+struct LexemeStart
+{
+  LexemeStart() {}
+
+  friend class Lexer;
+private:
+  std::vector<size_t> pos;
+};
+
 class Lexer
 {
 public:
-  Lexer() {}
-  Lexer(const char *fileName);
+  // tokens and decoded literals are made in region and stay valid until it is reset;
+  // without a region the lexer keeps one of its own and resets it for every new text. A
+  // region shared by several lexers may only be reset between units, when none of them
+  // is in the middle of a text
+  explicit Lexer(Arena *region = nullptr) : symbols(&symbolNames), engine(TABLE_DRIVEN) { init(region); }
+  Lexer(const char *fileName, LexerEngine engine = TABLE_DRIVEN, Arena *region = nullptr);
+  // lexes the caller's buffer in place, data[length] must be readable and equal to \0
+  Lexer(const char *data, size_t length, LexerEngine engine = TABLE_DRIVEN, Arena *region = nullptr);
 
   bool readFile(const char *fileName);
+  // like readFile, but lexes the caller's buffer, data[length] must be readable and equal to \0
+  void setText(const char *data, size_t length);
   Token *getNextToken();
+  // fills tokens with up to capacity lexemes and sets count to how many it wrote, which
+  // on BATCH_END and BATCH_ERROR are the ones before the end; always runs the automaton
+  BatchStatus getNextTokens(Lexeme *tokens, size_t capacity, size_t &count);
+  bool tokenize(TokenStream &stream);
+  // producer side of a pipeline: commits every remaining token to the ring and closes it
+  bool tokenize(TokenRing &ring);
+
+  // text of a literal without quotes; plain literals point straight into the source
+  StringSpan getLiteralValue(const Literal &literal);
+  StringSpan getLiteralValue(const TokenRef &token);
+
+  void setEngine(LexerEngine e) { engine = e; }
+  LexerEngine getEngine() const { return engine; }
+  LexerState getState() const { return state; }
+  const char *getText() const { return s; } // the source the lexemes' offsets refer to
+  size_t getTextLength() const { return sourceLength; }
+  size_t getOffset() const { return currentIndex; } // where lexing is, or where it stopped
+  // lines of the source, only found when a location is first asked for
+  LineIndex &getLineIndex() { return lines; }
+
+  // counters are added to until the stats are detached with nullptr
+  void setStats(LexerStats *s) { stats = s; }
+  LexerStats *getStats() const { return stats; }
+  // spans of the matchers and of skipSpaces, as far as the trace policy keeps them
+  TracePolicy &getTrace() { return trace; }
+
+  const ScopedSymbolTable &getSymbols() const { return symbols; }
 
 private:
   friend struct LexemeStart;
   friend struct TokenData;
+  friend class ParallelLexer;
+  friend class IncrementalLexer;
   static const CharToDigit charToDigit;
+  static const ScannerTables scannerTables;
 
-  std::string s;
+  SourceBuffer source;
+  const char *s;
+  size_t sourceLength;
   size_t currentIndex;
-  size_t currentLine;
-  SymbolTable *currentTable;
+  LineIndex lines;
+  StringInterner symbolNames;
+  ScopedSymbolTable symbols;
   LexerState state;
-  LexemeStart *lexemeStart; 
+  LexemeStart lexemeStart;
+  size_t tokenStart;  // of the cascade's last token, behind the blanks it skipped
+  LexerEngine engine;
+  Arena ownRegion;
+  Arena *region;
+  std::map<size_t, StringSpan> decodedLiterals;
+  bool deferSymbols;  // names are only interned, scopes are left to whoever merges the lexemes
+  bool validateInput; // off where the owner checks the encoding of the text itself
+  LexerStats *stats;
+  TracePolicy trace;
+
+  void init(Arena *region);
+  void onSourceLoaded();
+  void setRange(size_t begin, size_t end);
+
+  bool scan(Lexeme &lexeme);
+  bool onIdentifier(Lexeme &lexeme, uint32_t hash);
+  uint32_t putSymbol(const char *name, size_t length, uint32_t hash);
+  Token *makeToken(const Lexeme &lexeme);
+  StringSpan decodeLiteral(StringSpan text);
+  bool onReservedWord(ReservedWord::ReservedType type);
+  Token *getNextTokenByMatchers();
+  TokenData *countMatch(Matcher matcher, TokenData *data);
+  template <Matcher M, TokenData *(Lexer::*Match)()>
+  TokenData *runMatcher();
 
   void onStartMatch();
   TokenData * onEndMatch(Token * token = nullptr);
@@ -46,7 +159,6 @@ private:
   Token *onErrorToken();
 
   void skipSpaces();
-  int getSign();
 
   TokenData *getIntegerToken();
   TokenData *getFloatToken();
@@ -64,17 +176,7 @@ private:
   TokenData *getArithmeticToken();
   TokenData *getShiftToken();
   TokenData *getComparisonToken();
-};
-
-
-struct LexemeStart
-{
-  LexemeStart() {}
-
-  friend void Lexer::onStartMatch();
-  friend TokenData * Lexer::onEndMatch(Token * token);
-private:
-  std::vector<size_t> pos;
+  TokenData *getPunctuationToken();
 };
 
 
@@ -93,12 +195,13 @@ struct TokenData
   }
 
   bool hasNullToken() { return token == nullptr; }
+  Token *getToken() { return token; }
 
   size_t tokenLength;
 private:
   Token *token;
-  TokenData() : token(nullptr), tokenLength(0) {};
-  TokenData(Token *t, size_t l) : token(t), tokenLength(l) {};
+  TokenData() : tokenLength(0), token(nullptr) {};
+  TokenData(Token *t, size_t l) : tokenLength(l), token(t) {};
 
   friend TokenData * Lexer::onEndMatch(Token * token);
 };
@@ -0,0 +1,111 @@
+#include <cstring>
+#include <iomanip>
+#include "LexerStats.h"
+
+_LEX_BEGIN
+
+namespace
+{
+  const char *const typeNames[TOKEN_TYPE_COUNT] =
+  {
+    "integer", "float", "literal", "bool", "identifier", "reserved",
+    "comparison", "arithmetic", "shift", "bitwise binary", "bitwise not", "logic binary", "logic not", "assignment",
+    "(", ")", "[", "]", ";", ","
+  };
+
+  const char *const matcherNames[MATCHER_COUNT] =
+  {
+    "integer", "float", "literal", "boolean", "identifier", "assignment", "logic not",
+    "bitwise not", "logic binary", "bitwise binary", "arithmetic", "shift", "comparison",
+    "punctuation"
+  };
+}
+
+void LexerStats::reset()
+{
+  memset(tokens, 0, sizeof(tokens));
+  memset(matcherAttempts, 0, sizeof(matcherAttempts));
+  memset(matcherFailures, 0, sizeof(matcherFailures));
+  backtracks = backtrackedBytes = 0;
+  regionTokens = tokenDataAllocations = 0;
+  symbolHits = symbolMisses = 0;
+  whitespaceBytes = commentBytes = 0;
+}
+
+void LexerStats::add(const LexerStats &other)
+{
+  for (size_t i = 0; i < TOKEN_TYPE_COUNT; i++)
+    tokens[i] += other.tokens[i];
+  for (size_t i = 0; i < MATCHER_COUNT; i++)
+  {
+    matcherAttempts[i] += other.matcherAttempts[i];
+    matcherFailures[i] += other.matcherFailures[i];
+  }
+  backtracks += other.backtracks;
+  backtrackedBytes += other.backtrackedBytes;
+  regionTokens += other.regionTokens;
+  tokenDataAllocations += other.tokenDataAllocations;
+  symbolHits += other.symbolHits;
+  symbolMisses += other.symbolMisses;
+  whitespaceBytes += other.whitespaceBytes;
+  commentBytes += other.commentBytes;
+}
+
+const char *LexerStats::getTypeName(TokenType type)
+{
+  return typeNames[type];
+}
+
+const char *LexerStats::getMatcherName(Matcher matcher)
+{
+  return matcherNames[matcher];
+}
+
+namespace
+{
+  void printRow(std::ostream &out, const char *name, size_t value)
+  {
+    out << "  " << std::left << std::setw(16) << name << std::right << std::setw(11) << value << '\n';
+  }
+}
+
+// counts that stayed at zero are left out of the per type and per matcher lists
+void LexerStats::print(std::ostream &out) const
+{
+  size_t total = 0;
+  for (size_t i = 0; i < TOKEN_TYPE_COUNT; i++)
+    total += tokens[i];
+
+  out << "tokens" << std::setw(23) << total << '\n';
+  for (size_t i = 0; i < TOKEN_TYPE_COUNT; i++)
+  {
+    if (tokens[i])
+      printRow(out, typeNames[i], tokens[i]);
+  }
+
+  bool header = false;
+  for (size_t i = 0; i < MATCHER_COUNT; i++)
+  {
+    if (!matcherAttempts[i])
+      continue;
+    if (!header)
+      out << "matchers" << std::setw(21) << "attempts" << std::setw(11) << "failures" << '\n';
+    header = true;
+    out << "  " << std::left << std::setw(16) << matcherNames[i] << std::right
+      << std::setw(11) << matcherAttempts[i] << std::setw(11) << matcherFailures[i] << '\n';
+  }
+
+  out << "backtracks" << std::setw(19) << backtracks << " (" << backtrackedBytes << " bytes)\n";
+  out << "heap allocations\n";
+  printRow(out, "TokenData", tokenDataAllocations);
+  out << "region allocations\n";
+  printRow(out, "Token", regionTokens);
+  out << "symbols\n";
+  printRow(out, "hits", symbolHits);
+  printRow(out, "misses", symbolMisses);
+  out << "skipped bytes\n";
+  printRow(out, "whitespace", whitespaceBytes);
+  printRow(out, "comments", commentBytes);
+}
+
+_LEX_END
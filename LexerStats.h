@@ -0,0 +1,57 @@
+#pragma once
+
+#include <ostream>
+#include "Token.h"
+
+_LEX_BEGIN
+
+const size_t TOKEN_TYPE_COUNT = COMMA + 1;
+
+// getXxxToken functions of the matcher cascade
+enum Matcher
+{
+  MATCH_INTEGER,
+  MATCH_FLOAT,
+  MATCH_LITERAL,
+  MATCH_BOOLEAN,
+  MATCH_IDENTIFIER,
+  MATCH_ASSIGNMENT,
+  MATCH_LOGIC_NOT,
+  MATCH_BITWISE_NOT,
+  MATCH_LOGIC_BINARY,
+  MATCH_BITWISE_BINARY,
+  MATCH_ARITHMETIC,
+  MATCH_SHIFT,
+  MATCH_COMPARISON,
+  MATCH_PUNCTUATION,
+
+  MATCHER_COUNT
+};
+
+// counters a lexer fills in while one is attached with Lexer::setStats; without one every
+// event costs a test of a null pointer
+struct LexerStats
+{
+  LexerStats() { reset(); }
+
+  void reset();
+  void add(const LexerStats &other); // for totals over several lexers
+  void print(std::ostream &out) const;
+
+  static const char *getTypeName(TokenType type);
+  static const char *getMatcherName(Matcher matcher);
+
+  size_t tokens[TOKEN_TYPE_COUNT];
+  size_t matcherAttempts[MATCHER_COUNT];
+  size_t matcherFailures[MATCHER_COUNT];
+  size_t backtracks;            // failed matches rewound by onEndMatch, or automaton runs past the lexeme
+  size_t backtrackedBytes;
+  size_t regionTokens;          // tokens made in the lexer's region, a bump of a pointer each
+  size_t tokenDataAllocations;  // TokenData the cascade makes with new
+  size_t symbolHits;            // names already in the current scope
+  size_t symbolMisses;          // names the current scope gets a new entry for
+  size_t whitespaceBytes;
+  size_t commentBytes;
+};
+
+_LEX_END
@@ -0,0 +1,132 @@
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include "LexerTrace.h"
+
+_LEX_BEGIN
+
+const size_t ChromeTrace::MAX_EVENTS;
+const size_t ChromeTrace::SKIP;
+const size_t ChromeTrace::SPAN_COUNT;
+
+namespace
+{
+  const char *const bucketNames[LENGTH_BUCKET_COUNT] = { "1", "2", "3-4", "5-8", "9-16", "17-32", "33-64", "65+" };
+
+  const char *getSpanName(size_t span)
+  {
+    return (span == ChromeTrace::SKIP) ? "skip spaces" : LexerStats::getMatcherName(static_cast<Matcher>(span));
+  }
+
+  size_t getLengthBucket(size_t length)
+  {
+    if (length <= 1)
+      return 0;
+    size_t bucket = 64 - bits::countLeadingZeros(length - 1);
+    return bucket < LENGTH_BUCKET_COUNT ? bucket : LENGTH_BUCKET_COUNT - 1;
+  }
+}
+
+ChromeTrace::ChromeTrace()
+{
+  memset(calls, 0, sizeof(calls));
+  memset(matches, 0, sizeof(matches));
+  memset(cycles, 0, sizeof(cycles));
+  memset(lengths, 0, sizeof(lengths));
+  droppedEvents = 0;
+  originCycles = bits::readCycles();
+  originTime = std::chrono::steady_clock::now();
+}
+
+void ChromeTrace::record(Mark start, size_t span, bool matched)
+{
+  uint64_t duration = bits::readCycles() - start;
+  calls[span]++;
+  cycles[span] += duration;
+  if (matched)
+    matches[span]++;
+
+  if (events.size() == MAX_EVENTS)
+  {
+    droppedEvents++;
+    return;
+  }
+  Event event;
+  event.start = start;
+  event.duration = duration > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(duration);
+  event.span = static_cast<uint8_t>(span);
+  event.matched = matched;
+  events.push_back(event);
+}
+
+void ChromeTrace::endMatch(Mark start, Matcher matcher, Token *token, size_t length)
+{
+  record(start, matcher, token != nullptr);
+  if (token)
+    lengths[token->getType()][getLengthBucket(length)]++;
+}
+
+void ChromeTrace::endSkip(Mark start, size_t bytes)
+{
+  record(start, SKIP, bytes != 0);
+}
+
+// spans that never ran and types never made are left out
+void ChromeTrace::print(std::ostream &out) const
+{
+  out << "spans" << std::setw(24) << "calls" << std::setw(11) << "matched" << std::setw(14) << "cycles"
+    << std::setw(11) << "per call" << '\n';
+  for (size_t i = 0; i < SPAN_COUNT; i++)
+  {
+    if (!calls[i])
+      continue;
+    out << "  " << std::left << std::setw(16) << getSpanName(i) << std::right << std::setw(11) << calls[i]
+      << std::setw(10) << std::fixed << std::setprecision(1) << 100.0 * matches[i] / calls[i] << '%'
+      << std::setw(14) << cycles[i] << std::setw(11) << cycles[i] / calls[i] << '\n';
+  }
+
+  out << "token lengths   ";
+  for (size_t b = 0; b < LENGTH_BUCKET_COUNT; b++)
+    out << std::setw(9) << bucketNames[b];
+  out << '\n';
+  for (size_t t = 0; t < TOKEN_TYPE_COUNT; t++)
+  {
+    uint64_t total = 0;
+    for (size_t b = 0; b < LENGTH_BUCKET_COUNT; b++)
+      total += lengths[t][b];
+    if (!total)
+      continue;
+    out << "  " << std::left << std::setw(14) << LexerStats::getTypeName(static_cast<TokenType>(t)) << std::right;
+    for (size_t b = 0; b < LENGTH_BUCKET_COUNT; b++)
+      out << std::setw(9) << lengths[t][b];
+    out << '\n';
+  }
+  if (droppedEvents)
+    out << "events dropped" << std::setw(15) << droppedEvents << '\n';
+}
+
+// one complete ("X") event per span on a single thread; the rate of the cycle counter is
+// taken over the whole time traced, which is as steady as the counter itself
+bool ChromeTrace::write(const char *fileName) const
+{
+  FILE *f = fopen(fileName, "w");
+  if (f == nullptr)
+    return false;
+
+  double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - originTime).count();
+  double cyclesPerMicrosecond = (microseconds > 0) ? (bits::readCycles() - originCycles) / microseconds : 1;
+
+  fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  for (size_t i = 0; i < events.size(); i++)
+  {
+    const Event &event = events[i];
+    fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"matched\":%s}}",
+      i ? "," : "", getSpanName(event.span), event.span == SKIP ? "skip" : "matcher",
+      (event.start - originCycles) / cyclesPerMicrosecond, event.duration / cyclesPerMicrosecond,
+      event.matched ? "true" : "false");
+  }
+  fprintf(f, "\n]}\n");
+  return fclose(f) == 0;
+}
+
+_LEX_END
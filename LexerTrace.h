@@ -0,0 +1,80 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+#include <chrono>
+#include "LexerStats.h"
+#include "Bits.h"
+
+_LEX_BEGIN
+
+// trace policies take the hooks the lexer calls around every matcher of the cascade and
+// every skipSpaces. The lexer is compiled against one policy, named by LEX_TRACE_POLICY in
+// Lexer.h, so a profiling build and a production build differ in that define alone and
+// nothing is decided while lexing. Each policy provides:
+//
+//   Mark begin();                                             when a span starts
+//   void endMatch(Mark, Matcher, Token *token, size_t length); token is null on a failure
+//   void endSkip(Mark, size_t bytes);
+//   void print(std::ostream &out) const;
+//   bool write(const char *fileName) const;                   false if nothing is written
+
+// the default: every hook is empty and inline, so calling them leaves no code behind
+struct NullTrace
+{
+  typedef int Mark;
+
+  Mark begin() { return 0; }
+  void endMatch(Mark, Matcher, Token *, size_t) {}
+  void endSkip(Mark, size_t) {}
+  void print(std::ostream &) const {}
+  bool write(const char *) const { return false; }
+};
+
+// token lengths of 1, 2, 3-4, 5-8 and so on up to 65 and longer
+const size_t LENGTH_BUCKET_COUNT = 8;
+
+// cycles spent in each matcher and in skipSpaces, how often each matched, and the lengths of
+// the tokens made per type. Every span is also kept as a complete event of the Chrome trace
+// format, which chrome://tracing and Perfetto load; past MAX_EVENTS only the counts go on
+class ChromeTrace
+{
+public:
+  typedef uint64_t Mark;
+
+  static const size_t MAX_EVENTS = 1 << 20;
+  static const size_t SKIP = MATCHER_COUNT;    // span index of skipSpaces
+  static const size_t SPAN_COUNT = MATCHER_COUNT + 1;
+
+  ChromeTrace();
+
+  Mark begin() { return bits::readCycles(); }
+  void endMatch(Mark start, Matcher matcher, Token *token, size_t length);
+  void endSkip(Mark start, size_t bytes);
+  void print(std::ostream &out) const;
+  bool write(const char *fileName) const;
+
+  uint64_t calls[SPAN_COUNT];
+  uint64_t matches[SPAN_COUNT];  // skipSpaces counts the calls that skipped anything
+  uint64_t cycles[SPAN_COUNT];
+  uint64_t lengths[TOKEN_TYPE_COUNT][LENGTH_BUCKET_COUNT];
+  uint64_t droppedEvents;
+
+private:
+  struct Event
+  {
+    uint64_t start;
+    uint32_t duration;
+    uint8_t span;
+    bool matched;
+  };
+
+  // the clocks when tracing began, to turn cycles into the microseconds of the trace
+  uint64_t originCycles;
+  std::chrono::steady_clock::time_point originTime;
+  std::vector<Event> events;
+
+  void record(Mark start, size_t span, bool matched);
+};
+
+_LEX_END
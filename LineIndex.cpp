@@ -0,0 +1,41 @@
+#include <algorithm>
+#include "LineIndex.h"
+#include "CharScan.h"
+
+_LEX_BEGIN
+
+void LineIndex::reset(const char *t, size_t n)
+{
+  text = t;
+  length = n;
+  lineStarts.clear();
+  built = false;
+}
+
+void LineIndex::build()
+{
+  lineStarts.clear();
+  lineStarts.push_back(0);
+  findLineStarts(text, length, lineStarts);
+  built = true;
+}
+
+SourceLocation LineIndex::locate(size_t offset)
+{
+  if (!built)
+    build();
+
+  uint32_t at = static_cast<uint32_t>(std::min(offset, length));
+  // the last line starting at or before the offset
+  size_t line = std::upper_bound(lineStarts.begin(), lineStarts.end(), at) - lineStarts.begin() - 1;
+  return SourceLocation(static_cast<uint32_t>(line + 1), at - lineStarts[line] + 1);
+}
+
+size_t LineIndex::getLineCount()
+{
+  if (!built)
+    build();
+  return lineStarts.size();
+}
+
+_LEX_END
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "Token.h"
+
+_LEX_BEGIN
+
+// line and column of a byte offset, both counted from 1; the column counts bytes
+struct SourceLocation
+{
+  SourceLocation() : line(1), column(1) {}
+  SourceLocation(uint32_t line, uint32_t column) : line(line), column(column) {}
+
+  uint32_t line;
+  uint32_t column;
+};
+
+// where each line of a text starts, found the first time a location is asked for, so
+// lexing never counts lines itself
+class LineIndex
+{
+public:
+  LineIndex() : text(nullptr), length(0), built(false) {}
+  LineIndex(const char *text, size_t length) : text(text), length(length), built(false) {}
+
+  // the text is borrowed and has to outlive the queries
+  void reset(const char *text, size_t length);
+
+  // offsets past the end are placed at the end
+  SourceLocation locate(size_t offset);
+  size_t getLineCount();
+
+private:
+  const char *text;
+  size_t length;
+  std::vector<uint32_t> lineStarts;
+  bool built;
+
+  void build();
+};
+
+_LEX_END
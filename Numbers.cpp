@@ -0,0 +1,632 @@
+#include <climits>
+#include "Numbers.h"
+#include "Bits.h"
+
+_LEX_BEGIN
+
+using namespace bits;
+
+#define X NOT_A_DIGIT
+const unsigned char digitTable[256] =
+{
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  X,  X,  X,  X,  X,  X,
+   X, 10, 11, 12, 13, 14, 15,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X, 10, 11, 12, 13, 14, 15,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+   X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,  X,
+};
+#undef X
+
+// eight decimal digits in one word to their value, first digit most significant
+static inline uint64_t combineDecimal(uint64_t digits)
+{
+  digits = (digits * 10 + (digits >> 8)) & 0x00FF00FF00FF00FFULL;
+  digits = (digits * 100 + (digits >> 16)) & 0x0000FFFF0000FFFFULL;
+  return (digits * 10000 + (digits >> 32)) & 0xFFFFFFFFULL;
+}
+
+// eight digits of bitsPerDigit bits each; pairs, then quads, then halves are merged
+static inline uint64_t combinePowerOfTwo(uint64_t digits, unsigned bitsPerDigit)
+{
+  digits = ((digits & 0x00FF00FF00FF00FFULL) << bitsPerDigit) | ((digits >> 8) & 0x00FF00FF00FF00FFULL);
+  digits = ((digits & 0x0000FFFF0000FFFFULL) << (2 * bitsPerDigit)) | ((digits >> 16) & 0x0000FFFF0000FFFFULL);
+  return ((digits & 0xFFFFFFFFULL) << (4 * bitsPerDigit)) | (digits >> 32);
+}
+
+// digit values of eight chars at once, or false if any of them isn't a digit of base
+static inline bool wordDigits(uint64_t word, int base, uint64_t &digits)
+{
+  uint64_t valid;
+  if (base <= 10)
+    valid = bytesBetween(word, '0' - 1, '0' + base);
+  else
+    valid = bytesBetween(word, '0' - 1, '9' + 1) | bytesBetween(word | (ONES * 0x20), 'a' - 1, 'f' + 1);
+  if (valid != HIGHS)
+    return false;
+
+  // '0'-'9' keep their low nibble, letters have bit 6 set and get 9 added to theirs
+  digits = (word & (ONES * 0x0F)) + ((word >> 6) & ONES) * 9;
+  return true;
+}
+
+NumberStatus parseInteger(const char *digits, size_t count, int base, int &value)
+{
+  unsigned bitsPerDigit = 0;
+  switch (base)
+  {
+  case 2:
+    bitsPerDigit = 1;
+    break;
+  case 4:
+    bitsPerDigit = 2;
+    break;
+  case 8:
+    bitsPerDigit = 3;
+    break;
+  case 16:
+    bitsPerDigit = 4;
+    break;
+  }
+
+  const uint64_t limit = (base == 10) ? INT_MAX : 0xFFFFFFFFULL;
+  uint64_t result = 0;
+  size_t i = 0;
+
+  // the accumulator stays at or under 2^32 before each step, so no step can wrap 64 bits
+  for (; i + 8 <= count; i += 8)
+  {
+    uint64_t word;
+    if (!wordDigits(load64(digits + i), base, word))
+      return NUMBER_INVALID;
+
+    if (base == 10)
+      result = result * 100000000 + combineDecimal(word);
+    else
+      result = (result << (8 * bitsPerDigit)) | combinePowerOfTwo(word, bitsPerDigit);
+    if (result > limit)
+      return NUMBER_OVERFLOW;
+  }
+
+  for (; i < count; i++)
+  {
+    unsigned digit = digitTable[static_cast<unsigned char>(digits[i])];
+    if (digit >= static_cast<unsigned>(base))
+      return NUMBER_INVALID;
+    result = result * base + digit;
+    if (result > limit)
+      return NUMBER_OVERFLOW;
+  }
+
+  value = static_cast<int>(static_cast<uint32_t>(result));
+  return NUMBER_OK;
+}
+
+// how a binary format is laid out, and the powers of ten where its range ends
+struct FloatFormat
+{
+  int mantissaBits;       // stored bits, the leading 1 of normal numbers is implied
+  int minimumExponent;    // bias, negated
+  int infinitePower;      // biased exponent of infinity
+  int minRoundToEven;     // powers of ten between these can give values exactly halfway
+  int maxRoundToEven;     // between two floats
+  int smallestPowerOfTen; // 19 digits times a smaller power of ten round to 0
+  int largestPowerOfTen;  // any digits times a larger one overflow
+};
+
+static const FloatFormat DOUBLE_FORMAT = { 52, -1023, 0x7FF, -4, 23, -342, 308 };
+static const FloatFormat FLOAT_FORMAT = { 23, -127, 0xFF, -17, 10, -64, 38 };
+
+static const int MAX_FAST_DIGITS = 19;
+
+// a float before it is packed: the stored mantissa bits and the biased exponent
+struct BinaryFloat
+{
+  uint64_t mantissa;
+  int power2;
+
+  bool operator==(const BinaryFloat &other) const { return mantissa == other.mantissa && power2 == other.power2; }
+  bool operator!=(const BinaryFloat &other) const { return !(*this == other); }
+};
+
+static inline bool isDigit(char c)
+{
+  return static_cast<unsigned>(c - '0') < 10;
+}
+
+// appends the next eight chars to digits if they are all digits
+static inline bool takeEightDigits(const char *&p, const char *end, uint64_t &digits)
+{
+  if (end - p < 8)
+    return false;
+  uint64_t word = load64(p);
+  if (bytesBetween(word, '0' - 1, '9' + 1) != HIGHS)
+    return false;
+  digits = digits * 100000000 + combineDecimal(word - ONES * '0');
+  p += 8;
+  return true;
+}
+
+// reads the significand, up to its first 19 significant digits, and the power of ten that
+// goes with them; truncated tells if any of the digits left out isn't 0
+static void readDecimal(const char *p, const char *end, uint64_t &significand, int64_t &exponent, bool &truncated)
+{
+  uint64_t digits = 0;
+  int count = 0;
+  int64_t power = 0;
+  truncated = false;
+
+  while (p < end && *p == '0')
+    p++;
+  while (count + 8 <= MAX_FAST_DIGITS && takeEightDigits(p, end, digits))
+    count += 8;
+  for (; p < end && isDigit(*p); p++)
+  {
+    if (count < MAX_FAST_DIGITS)
+    {
+      digits = digits * 10 + (*p - '0');
+      count++;
+    }
+    else
+    {
+      power++;
+      truncated |= *p != '0';
+    }
+  }
+
+  if (p < end && *p == '.')
+  {
+    p++;
+    if (count == 0)
+    {
+      for (; p < end && *p == '0'; p++)
+        power--;
+    }
+
+    while (count + 8 <= MAX_FAST_DIGITS && takeEightDigits(p, end, digits))
+    {
+      count += 8;
+      power -= 8;
+    }
+    for (; p < end && isDigit(*p); p++)
+    {
+      if (count < MAX_FAST_DIGITS)
+      {
+        digits = digits * 10 + (*p - '0');
+        count++;
+        power--;
+      }
+      else
+        truncated |= *p != '0';
+    }
+  }
+
+  if (p < end && (*p == 'e' || *p == 'E'))
+  {
+    p++;
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+')
+      p++;
+    int64_t written = 0;
+    for (; p < end && isDigit(*p); p++)
+    {
+      if (written < 100000000) // far past any range, and no overflow
+        written = written * 10 + (*p - '0');
+    }
+    power += negative ? -written : written;
+  }
+
+  significand = digits;
+  exponent = power;
+}
+
+// the Eisel-Lemire algorithm: w * 5^q from the 128-bit table, then 2^q folded into the
+// exponent; the product's top bits are exact enough to round correctly
+static BinaryFloat computeFloat(const FloatFormat &format, uint64_t w, int64_t q)
+{
+  BinaryFloat result = { 0, 0 };
+  if (w == 0 || q < format.smallestPowerOfTen)
+    return result;
+  if (q > format.largestPowerOfTen)
+  {
+    result.power2 = format.infinitePower;
+    return result;
+  }
+
+  int leadingZeros = countLeadingZeros(w);
+  w <<= leadingZeros;
+
+  const uint64_t *power = powersOfFive[q - SMALLEST_POWER_OF_FIVE];
+  uint64_t high;
+  uint64_t low = multiplyFull(w, power[0], high);
+  uint64_t precisionMask = ~0ULL >> (format.mantissaBits + 3);
+  if ((high & precisionMask) == precisionMask) // the bits below the ones kept may carry
+  {
+    uint64_t secondHigh;
+    multiplyFull(w, power[1], secondHigh);
+    low += secondHigh;
+    if (secondHigh > low)
+      high++;
+  }
+
+  int upperBit = static_cast<int>(high >> 63);
+  int shift = upperBit + 64 - format.mantissaBits - 3;
+  result.mantissa = high >> shift;
+  // floor(log2(10^q)) + 63, which is where 2^q * 5^q puts the product's top bit
+  int log2 = (((152170 + 65536) * static_cast<int>(q)) >> 16) + 63;
+  result.power2 = log2 + upperBit - leadingZeros - format.minimumExponent;
+
+  if (result.power2 <= 0) // subnormal, exact ties can't come from so few digits
+  {
+    if (-result.power2 + 1 >= 64)
+    {
+      result.mantissa = 0;
+      result.power2 = 0;
+      return result;
+    }
+    result.mantissa >>= -result.power2 + 1;
+    result.mantissa += result.mantissa & 1;
+    result.mantissa >>= 1;
+    result.power2 = (result.mantissa < (1ULL << format.mantissaBits)) ? 0 : 1;
+    return result;
+  }
+
+  // exactly halfway: the product has nothing below the round bit, so round to even
+  if (low <= 1 && q >= format.minRoundToEven && q <= format.maxRoundToEven && (result.mantissa & 3) == 1 &&
+    (result.mantissa << shift) == high)
+    result.mantissa &= ~1ULL;
+
+  result.mantissa += result.mantissa & 1;
+  result.mantissa >>= 1;
+  if (result.mantissa >= (2ULL << format.mantissaBits))
+  {
+    result.mantissa = 1ULL << format.mantissaBits;
+    result.power2++;
+  }
+  result.mantissa &= ~(1ULL << format.mantissaBits);
+
+  if (result.power2 >= format.infinitePower)
+  {
+    result.mantissa = 0;
+    result.power2 = format.infinitePower;
+  }
+  return result;
+}
+
+// unsigned integer of up to MAX_LIMBS 32-bit limbs, least significant first; enough for
+// every number the slow path builds out of MAX_SLOW_DIGITS digits
+class BigInteger
+{
+public:
+  static const size_t MAX_LIMBS = 160;
+
+  BigInteger() : size(0) {}
+  explicit BigInteger(uint32_t value) : size(0) { if (value) limbs[size++] = value; }
+
+  bool isZero() const { return size == 0; }
+
+  void multiplyAdd(uint32_t factor, uint32_t addend)
+  {
+    uint64_t carry = addend;
+    for (size_t i = 0; i < size; i++)
+    {
+      carry += static_cast<uint64_t>(limbs[i]) * factor;
+      limbs[i] = static_cast<uint32_t>(carry);
+      carry >>= 32;
+    }
+    if (carry)
+      limbs[size++] = static_cast<uint32_t>(carry);
+  }
+
+  void multiplyByPowerOfTen(int64_t n)
+  {
+    for (; n >= 9; n -= 9)
+      multiplyAdd(1000000000, 0);
+    static const uint32_t smallPowers[9] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+    if (n > 0)
+      multiplyAdd(smallPowers[n], 0);
+  }
+
+  void shiftLeft(size_t bits)
+  {
+    if (isZero())
+      return;
+    size_t limbShift = bits / 32;
+    unsigned bitShift = bits % 32;
+    if (bitShift)
+    {
+      uint32_t carry = 0;
+      for (size_t i = 0; i < size; i++)
+      {
+        uint32_t limb = limbs[i];
+        limbs[i] = (limb << bitShift) | carry;
+        carry = limb >> (32 - bitShift);
+      }
+      if (carry)
+        limbs[size++] = carry;
+    }
+    if (limbShift)
+    {
+      memmove(limbs + limbShift, limbs, size * sizeof(uint32_t));
+      memset(limbs, 0, limbShift * sizeof(uint32_t));
+      size += limbShift;
+    }
+  }
+
+  size_t bitLength() const
+  {
+    if (isZero())
+      return 0;
+    return size * 32 - (countLeadingZeros(limbs[size - 1]) - 32);
+  }
+
+  int compare(const BigInteger &other) const
+  {
+    if (size != other.size)
+      return (size < other.size) ? -1 : 1;
+    for (size_t i = size; i-- > 0;)
+    {
+      if (limbs[i] != other.limbs[i])
+        return (limbs[i] < other.limbs[i]) ? -1 : 1;
+    }
+    return 0;
+  }
+
+  void subtract(const BigInteger &other) // other mustn't be larger
+  {
+    int64_t borrow = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+      int64_t difference = static_cast<int64_t>(limbs[i]) - (i < other.size ? other.limbs[i] : 0) - borrow;
+      borrow = difference < 0;
+      limbs[i] = static_cast<uint32_t>(difference);
+    }
+    while (size && limbs[size - 1] == 0)
+      size--;
+  }
+
+private:
+  uint32_t limbs[MAX_LIMBS];
+  size_t size;
+};
+
+// more digits than this never change which of two doubles is nearer, what is cut off only
+// counts as a 1 after them
+static const int MAX_SLOW_DIGITS = 800;
+
+// every significant digit of the literal, or the first MAX_SLOW_DIGITS of them
+static int readAllDigits(const char *p, const char *end, BigInteger &digits, int64_t &exponent)
+{
+  int count = 0;
+  int64_t power = 0;
+  bool truncated = false;
+  uint32_t chunk = 0;
+  int chunkDigits = 0;
+  static const uint32_t chunkScale[10] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+  while (p < end && *p == '0')
+    p++;
+  bool fraction = false;
+  for (; p < end; p++)
+  {
+    if (*p == '.')
+    {
+      fraction = true;
+      if (count == 0)
+      {
+        for (p++; p < end && *p == '0'; p++)
+          power--;
+        p--;
+      }
+      continue;
+    }
+    if (!isDigit(*p))
+      break;
+
+    if (count < MAX_SLOW_DIGITS)
+    {
+      chunk = chunk * 10 + (*p - '0');
+      if (++chunkDigits == 9)
+      {
+        digits.multiplyAdd(chunkScale[9], chunk);
+        chunk = 0;
+        chunkDigits = 0;
+      }
+      count++;
+      if (fraction)
+        power--;
+    }
+    else
+    {
+      truncated |= *p != '0';
+      if (!fraction)
+        power++;
+    }
+  }
+  if (truncated)
+  {
+    chunk = chunk * 10 + 1;
+    chunkDigits++;
+    count++;
+    power--;
+  }
+  if (chunkDigits)
+    digits.multiplyAdd(chunkScale[chunkDigits], chunk);
+
+  if (p < end && (*p == 'e' || *p == 'E'))
+  {
+    p++;
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+')
+      p++;
+    int64_t written = 0;
+    for (; p < end && isDigit(*p); p++)
+    {
+      if (written < 100000000)
+        written = written * 10 + (*p - '0');
+    }
+    power += negative ? -written : written;
+  }
+
+  exponent = power;
+  return count;
+}
+
+// q = floor(x / y) for a q below 2^bits, x is left with the remainder
+static uint64_t divide(BigInteger &x, const BigInteger &y, int bits)
+{
+  uint64_t quotient = 0;
+  for (int i = bits - 1; i >= 0; i--)
+  {
+    BigInteger shifted = y;
+    shifted.shiftLeft(i);
+    if (x.compare(shifted) >= 0)
+    {
+      x.subtract(shifted);
+      quotient |= 1ULL << i;
+    }
+  }
+  return quotient;
+}
+
+// exact conversion for what computeFloat can't settle: the value is the fraction a / b of two
+// big integers, which is scaled by 2^s until its integer part has one bit more than the
+// mantissa; that bit and whether anything is left over decide the rounding
+static BinaryFloat computeFloatExactly(const FloatFormat &format, const char *text, size_t length)
+{
+  BinaryFloat result = { 0, 0 };
+  BigInteger digits;
+  int64_t exponent;
+  int count = readAllDigits(text, text + length, digits, exponent);
+  if (digits.isZero() || exponent + count <= format.smallestPowerOfTen)
+    return result;
+  if (exponent + count > format.largestPowerOfTen + 1)
+  {
+    result.power2 = format.infinitePower;
+    return result;
+  }
+
+  BigInteger a = digits;
+  BigInteger b(1);
+  if (exponent >= 0)
+    a.multiplyByPowerOfTen(exponent);
+  else
+    b.multiplyByPowerOfTen(-exponent);
+
+  const int precision = format.mantissaBits + 1;
+  const int64_t smallestUnit = format.minimumExponent + 1 - format.mantissaBits; // of subnormals
+  int64_t s = precision - (static_cast<int64_t>(a.bitLength()) - static_cast<int64_t>(b.bitLength()));
+
+  BigInteger x, y;
+  for (int attempt = 0; attempt < 2; attempt++)
+  {
+    if (s > 1 - smallestUnit)
+      s = 1 - smallestUnit;
+    x = a;
+    y = b;
+    if (s >= 0)
+      x.shiftLeft(static_cast<size_t>(s));
+    else
+      y.shiftLeft(static_cast<size_t>(-s));
+
+    BigInteger lowest = y;
+    lowest.shiftLeft(precision);
+    if (s == 1 - smallestUnit || x.compare(lowest) >= 0)
+      break;
+    s++;
+  }
+
+  uint64_t quotient = divide(x, y, precision + 1);
+  uint64_t mantissa = quotient >> 1;
+  int64_t unit = 1 - s;
+  if ((quotient & 1) && (!x.isZero() || (mantissa & 1)))
+    mantissa++;
+  if (mantissa == (1ULL << precision))
+  {
+    mantissa >>= 1;
+    unit++;
+  }
+
+  if (mantissa < (1ULL << format.mantissaBits)) // subnormal, or 0 once rounded
+  {
+    result.mantissa = mantissa;
+    return result;
+  }
+  int64_t power2 = unit + format.mantissaBits - format.minimumExponent;
+  if (power2 >= format.infinitePower)
+  {
+    result.power2 = format.infinitePower;
+    return result;
+  }
+  result.mantissa = mantissa & ~(1ULL << format.mantissaBits);
+  result.power2 = static_cast<int>(power2);
+  return result;
+}
+
+static BinaryFloat convertDecimal(const FloatFormat &format, uint64_t significand, int64_t exponent, bool truncated,
+  const char *text, size_t length)
+{
+  BinaryFloat result = computeFloat(format, significand, exponent);
+  // the digits cut off put the value between these two, if both round the same way so does it
+  if (truncated && computeFloat(format, significand + 1, exponent) != result)
+    result = computeFloatExactly(format, text, length);
+  return result;
+}
+
+static const double exactPowersOfTen[23] =
+{
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+NumberStatus parseDouble(const char *text, size_t length, double &value)
+{
+  uint64_t significand;
+  int64_t exponent;
+  bool truncated;
+  readDecimal(text, text + length, significand, exponent, truncated);
+
+  // both operands exact, so the one rounding IEEE arithmetic does is the right one
+  if (!truncated && significand <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+  {
+    value = static_cast<double>(significand);
+    value = (exponent < 0) ? value / exactPowersOfTen[-exponent] : value * exactPowersOfTen[exponent];
+    return NUMBER_OK;
+  }
+
+  BinaryFloat result = convertDecimal(DOUBLE_FORMAT, significand, exponent, truncated, text, length);
+  if (result.power2 == DOUBLE_FORMAT.infinitePower)
+    return NUMBER_OVERFLOW;
+
+  uint64_t bits = result.mantissa | (static_cast<uint64_t>(result.power2) << DOUBLE_FORMAT.mantissaBits);
+  memcpy(&value, &bits, sizeof(value));
+  return NUMBER_OK;
+}
+
+NumberStatus parseFloat(const char *text, size_t length, float &value)
+{
+  uint64_t significand;
+  int64_t exponent;
+  bool truncated;
+  readDecimal(text, text + length, significand, exponent, truncated);
+
+  BinaryFloat result = convertDecimal(FLOAT_FORMAT, significand, exponent, truncated, text, length);
+  if (result.power2 == FLOAT_FORMAT.infinitePower)
+    return NUMBER_OVERFLOW;
+
+  uint32_t bits = static_cast<uint32_t>(result.mantissa) | (static_cast<uint32_t>(result.power2) << FLOAT_FORMAT.mantissaBits);
+  memcpy(&value, &bits, sizeof(value));
+  return NUMBER_OK;
+}
+
+_LEX_END
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include "Token.h"
+
+_LEX_BEGIN
+
+const unsigned char NOT_A_DIGIT = 0xFF;
+
+// value of every byte as a digit of base 16 or less, NOT_A_DIGIT otherwise
+extern const unsigned char digitTable[256];
+
+struct CharToDigit
+{
+public:
+  int getDigit(char c) const
+  {
+    unsigned char digit = digitTable[static_cast<unsigned char>(c)];
+    return (digit == NOT_A_DIGIT) ? -1 : digit;
+  }
+};
+
+enum NumberStatus
+{
+  NUMBER_OK,
+  NUMBER_INVALID,   // a character isn't a digit of the base
+  NUMBER_OVERFLOW
+};
+
+// converts count digits of base 2, 4, 8, 10 or 16 with no prefix; decimal literals
+// must fit an int, the others are bit patterns of up to 32 bits
+NumberStatus parseInteger(const char *digits, size_t count, int base, int &value);
+
+// convert digits [. digits] [e|E [+|-] digits] without a suffix to the nearest float or
+// double, ties to even; too large a value is NUMBER_OVERFLOW, too small a one becomes 0.
+// Up to 19 significant digits and a power of ten within range take the Eisel-Lemire path,
+// which needs no more than two 64-bit multiplications; what that can't decide is settled
+// exactly with big integers
+NumberStatus parseFloat(const char *text, size_t length, float &value);
+NumberStatus parseDouble(const char *text, size_t length, double &value);
+
+const int SMALLEST_POWER_OF_FIVE = -342;
+const int LARGEST_POWER_OF_FIVE = 308;
+const size_t POWERS_OF_FIVE_COUNT = LARGEST_POWER_OF_FIVE - SMALLEST_POWER_OF_FIVE + 1;
+
+// 128-bit approximations of the powers of five, high word first
+extern const uint64_t powersOfFive[POWERS_OF_FIVE_COUNT][2];
+
+_LEX_END
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include "ParallelLexer.h"
+#include "CharScan.h"
+
+_LEX_BEGIN
+
+const size_t ParallelLexer::MIN_CHUNK_SIZE;
+const size_t ParallelLexer::CHUNKS_PER_THREAD;
+
+ParallelLexer::ParallelLexer(size_t threadCount) : symbols(&symbolNames), pool(threadCount)
+{
+  s = source.data();
+  sourceLength = 0;
+  stopOffset = 0;
+  state = FINISHED;
+}
+
+bool ParallelLexer::readFile(const char *fileName)
+{
+  if (!source.mapFile(fileName))
+  {
+    state = WRONG_FILE;
+    return false;
+  }
+
+  onSourceLoaded();
+  return true;
+}
+
+void ParallelLexer::setSource(const char *data, size_t length)
+{
+  source.assign(data, length);
+  onSourceLoaded();
+}
+
+// a new text is a unit of its own, as for Lexer: its scopes and names start empty
+void ParallelLexer::onSourceLoaded()
+{
+  symbols.clear();
+  symbolNames.clear();
+  s = source.data();
+  sourceLength = source.size();
+  stopOffset = 0;
+  state = (sourceLength <= UINT32_MAX) ? PARSING : WRONG_FILE;
+}
+
+bool ParallelLexer::tokenize(TokenStream &stream)
+{
+  stream.setSource(s);
+  if (state != PARSING)
+    return false;
+
+  size_t chunkCount = std::min(pool.size() * CHUNKS_PER_THREAD, sourceLength / MIN_CHUNK_SIZE);
+  std::vector<size_t> splits;
+  findSplits(std::max<size_t>(chunkCount, 1), splits);
+
+  std::vector<Chunk> chunks(splits.size() - 1);
+  for (size_t i = 0; i < chunks.size(); i++)
+  {
+    Chunk *chunk = &chunks[i];
+    chunk->begin = splits[i];
+    chunk->end = splits[i + 1];
+    chunk->lexer = new Lexer;
+    chunk->lexer->deferSymbols = true;
+    chunk->lexer->validateInput = false; // each chunk checks its own range
+    chunk->lexer->setText(s, sourceLength);
+    chunk->lexer->setRange(chunk->begin, chunk->end);
+    pool.submit([chunk]() { lexChunk(chunk); });
+  }
+  pool.wait();
+
+  // the single threaded lexer checks the whole text before it lexes anything
+  for (size_t i = 0; i < chunks.size(); i++)
+  {
+    if (chunks[i].invalid != chunks[i].end)
+    {
+      stopOffset = chunks[i].invalid;
+      state = WRONG_ENCODING;
+      for (size_t j = 0; j < chunks.size(); j++)
+        delete chunks[j].lexer;
+      return false;
+    }
+  }
+
+  resolveSymbols(chunks);
+  stream.resize(chunks.back().first + chunks.back().kept);
+  for (size_t i = 0; i < chunks.size(); i++)
+  {
+    Chunk *chunk = &chunks[i];
+    TokenStream *out = &stream;
+    pool.submit([chunk, out]() { writeChunk(chunk, out); });
+  }
+  pool.wait();
+
+  for (size_t i = 0; i < chunks.size(); i++)
+    delete chunks[i].lexer;
+  return state == FINISHED;
+}
+
+// splits are ASCII blanks, so no UTF-8 sequence crosses from one chunk into the next
+void ParallelLexer::lexChunk(Chunk *chunk)
+{
+  const char *text = chunk->lexer->getText();
+  chunk->invalid = findInvalidUtf8(text + chunk->begin, text + chunk->end) - text;
+  if (chunk->invalid != chunk->end)
+    return;
+
+  chunk->lexemes.reserve((chunk->end - chunk->begin) / 4);
+
+  Lexeme lexeme;
+  while (chunk->lexer->scan(lexeme))
+    chunk->lexemes.push_back(lexeme);
+}
+
+// chunk boundaries are blanks outside comments and literals, taken at or after evenly
+// spaced targets; the walk follows the same comment and literal rules as Lexer::skipSpaces
+// and the scanner, so the lexer is between two lexemes at each of them
+void ParallelLexer::findSplits(size_t chunkCount, std::vector<size_t> &splits) const
+{
+  const char *text = s;
+  const char *end = s + sourceLength;
+  size_t step = sourceLength / chunkCount;
+
+  splits.push_back(0);
+  const char *p = text;
+  while (p < end && splits.size() < chunkCount)
+  {
+    // [p, code) holds lexemes and blanks only, any blank in it will do
+    const char *code = findCommentOrLiteral(p, end);
+    const char *target = text + splits.size() * step;
+    while (target < code && splits.size() < chunkCount)
+    {
+      const char *blank = findBlank(std::max(p, target), code);
+      if (blank == code)
+        break;
+      splits.push_back(blank - text);
+      target = std::max(blank + 1, text + splits.size() * step);
+    }
+
+    p = code;
+    if (p == end || *p == 0) // the lexer stops at a \0 outside comments and literals
+      break;
+
+    if (*p == '"')
+    {
+      bool hasEscapes = false;
+      p = scanStringBody(p + 1, end, hasEscapes);
+      if (*p != '"') // unterminated, the lexer stops in here
+        break;
+      p++;
+    }
+    else if (p + 1 < end && p[1] == '/')
+      p = findLineEnd(p + 2, end);
+    else if (p + 1 < end && p[1] == '*')
+      p = skipBlockComment(p + 2, end);
+    else
+      p++; // division
+  }
+
+  splits.push_back(sourceLength);
+}
+
+// replays scope changes over the lexemes of all chunks in order and enters the names into
+// the symbol table the way the single threaded lexer would have; stops where it would have
+void ParallelLexer::resolveSymbols(std::vector<Chunk> &chunks)
+{
+  std::vector<uint32_t> nameIds;
+  size_t first = 0;
+  state = FINISHED;
+
+  for (size_t i = 0; i < chunks.size(); i++)
+  {
+    Chunk &chunk = chunks[i];
+    Lexer &lexer = *chunk.lexer;
+    chunk.first = first;
+    chunk.kept = 0;
+    if (state != FINISHED)
+      continue;
+
+    nameIds.assign(lexer.symbolNames.size(), StringInterner::NOT_FOUND);
+    for (; chunk.kept < chunk.lexemes.size(); chunk.kept++)
+    {
+      Lexeme &lexeme = chunk.lexemes[chunk.kept];
+      if (lexeme.type == IDENTIFIER)
+      {
+        uint32_t localId = static_cast<uint32_t>(lexeme.symbolIndex);
+        if (nameIds[localId] == StringInterner::NOT_FOUND)
+          nameIds[localId] = symbolNames.intern(lexer.symbolNames.getName(localId), lexer.symbolNames.getLength(localId));
+        lexeme.symbolIndex = symbols.put(DataType::UNKNOWN, nameIds[localId]);
+        lexeme.scope = symbols.getScope();
+      }
+      else if (lexeme.type == RESERVED && lexeme.subtype == ReservedWord::BEGIN)
+        symbols.enterScope();
+      else if (lexeme.type == RESERVED && lexeme.subtype == ReservedWord::END)
+      {
+        if (!symbols.exitScope())
+        {
+          stopOffset = lexeme.offset + lexeme.length; // Lexer stops after the end
+          state = SYNTAX_ERROR;
+          break;
+        }
+      }
+    }
+
+    first += chunk.kept;
+    if (state == FINISHED)
+    {
+      stopOffset = lexer.currentIndex;
+      state = lexer.state;
+    }
+  }
+}
+
+void ParallelLexer::writeChunk(Chunk *chunk, TokenStream *stream)
+{
+  if (chunk->kept)
+    stream->write(chunk->first, &chunk->lexemes[0], chunk->kept);
+}
+
+_LEX_END
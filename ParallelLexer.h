@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include "Lexer.h"
+#include "ThreadPool.h"
+
+_LEX_BEGIN
+
+// lexes one large text in chunks on a thread pool; the stream it fills is the one
+// Lexer::tokenize would give for the same text
+class ParallelLexer
+{
+public:
+  explicit ParallelLexer(size_t threadCount = 0); // 0 uses every hardware thread
+
+  bool readFile(const char *fileName);
+  // lexes the caller's buffer in place, data[length] must be readable and equal to \0
+  void setSource(const char *data, size_t length);
+  bool tokenize(TokenStream &stream);
+
+  const char *getText() const { return s; } // the source the lexemes' offsets refer to
+  size_t getTextLength() const { return sourceLength; }
+  LexerState getState() const { return state; }
+  size_t getOffset() const { return stopOffset; } // where lexing stopped
+  const ScopedSymbolTable &getSymbols() const { return symbols; }
+
+private:
+  ParallelLexer(const ParallelLexer &);
+  ParallelLexer &operator=(const ParallelLexer &);
+
+  static const size_t MIN_CHUNK_SIZE = 256 * 1024;
+  static const size_t CHUNKS_PER_THREAD = 4;
+
+  struct Chunk
+  {
+    size_t begin;
+    size_t end;
+    Lexer *lexer;
+    std::vector<Lexeme> lexemes;
+    size_t kept;    // lexemes that make it into the stream
+    size_t first;   // stream index of the first of them
+    size_t invalid; // first byte that isn't UTF-8, end if there is none
+  };
+
+  SourceBuffer source;
+  const char *s;
+  size_t sourceLength;
+  size_t stopOffset;
+  StringInterner symbolNames;
+  ScopedSymbolTable symbols;
+  LexerState state;
+  ThreadPool pool;
+
+  void onSourceLoaded();
+  void findSplits(size_t chunkCount, std::vector<size_t> &splits) const;
+  static void lexChunk(Chunk *chunk);
+  void resolveSymbols(std::vector<Chunk> &chunks);
+  static void writeChunk(Chunk *chunk, TokenStream *stream);
+};
+
+_LEX_END
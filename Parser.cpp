@@ -0,0 +1,422 @@
+#include "Parser.h"
+
+_LEX_BEGIN
+
+const unsigned Parser::MAX_NESTING;
+
+// counts one level of nesting for as long as it is in scope
+struct NestingLevel
+{
+  explicit NestingLevel(unsigned &nesting) : nesting(nesting) { nesting++; }
+  ~NestingLevel() { nesting--; }
+
+  unsigned &nesting;
+};
+
+Parser::Parser(const TokenView &tokens) : tokens(tokens), ring(nullptr), stream(nullptr), pos(0), tree(nullptr),
+  nesting(0), errorToken(0), error(nullptr)
+{
+}
+
+Parser::Parser(TokenRing &ring, TokenStream &stream) : ring(&ring), stream(&stream), pos(0), tree(nullptr),
+  nesting(0), errorToken(0), error(nullptr)
+{
+}
+
+bool Parser::parse(Syntax &result)
+{
+  tree = &result;
+  tree->clear();
+  pos = 0;
+  pending.clear();
+  nesting = 0;
+  errorToken = 0;
+  error = nullptr;
+
+  bool parsed = parseProgram();
+  if (ring)
+    ring->stop();
+  return parsed;
+}
+
+bool Parser::parseProgram()
+{
+  while (!atEnd())
+  {
+    if (at(SEMICOLON))
+    {
+      pos++;
+      continue;
+    }
+    NodeIndex statement = parseStatement();
+    if (statement == NO_NODE)
+      return false;
+    pending.push_back(statement);
+  }
+
+  size_t count;
+  NodeIndex items = closeList(0, count);
+  tree->setRoot(tree->add(NODE_BLOCK, 0, items, static_cast<NodeIndex>(count)));
+  return true;
+}
+
+// waits for the producer until token i is in the stream, false if it never will be
+bool Parser::pull(size_t i)
+{
+  while (i >= tokens.size())
+  {
+    const Lexeme *lexemes;
+    size_t count = ring->peek(lexemes);
+    if (count == 0)
+      return false;
+    for (size_t j = 0; j < count; j++)
+      stream->push(lexemes[j]);
+    ring->release(count);
+    tokens = stream->view();
+  }
+  return true;
+}
+
+bool Parser::atReserved(ReservedWord::ReservedType word)
+{
+  return at(RESERVED) && tokens[pos].getSubtype() == word;
+}
+
+// keeps the first error, the ones after it are only its echo on the way out
+NodeIndex Parser::fail(const char *message)
+{
+  if (error == nullptr)
+  {
+    error = message;
+    errorToken = pos;
+  }
+  return NO_NODE;
+}
+
+// moves the items pushed since start from the pending stack into the tree
+NodeIndex Parser::closeList(size_t start, size_t &count)
+{
+  count = pending.size() - start;
+  NodeIndex items = tree->addList(count ? &pending[start] : nullptr, count);
+  pending.resize(start);
+  return items;
+}
+
+NodeIndex Parser::parseStatement()
+{
+  if (nesting == MAX_NESTING)
+    return fail("nested too deeply");
+  NestingLevel level(nesting);
+
+  if (at(RESERVED))
+  {
+    switch (tokens[pos].getSubtype())
+    {
+    case ReservedWord::BEGIN:
+      return parseBlock();
+    case ReservedWord::IF:
+      return parseIf();
+    case ReservedWord::WHILE:
+      return parseWhile();
+    case ReservedWord::FOR:
+      return parseFor();
+    default:
+      return fail("end, elif or else without the statement it belongs to");
+    }
+  }
+
+  if (at(SEMICOLON)) // the empty body of an if, while or for
+  {
+    NodeIndex items = tree->addList(nullptr, 0);
+    return tree->add(NODE_BLOCK, pos++, items, 0);
+  }
+
+  NodeIndex statement = parseSimple();
+  if (statement != NO_NODE && at(SEMICOLON))
+    pos++;
+  return statement;
+}
+
+NodeIndex Parser::parseBlock()
+{
+  size_t begin = pos++;
+  size_t start = pending.size();
+
+  while (!atReserved(ReservedWord::END))
+  {
+    if (atEnd())
+      return fail("begin without end");
+    if (at(SEMICOLON))
+    {
+      pos++;
+      continue;
+    }
+    NodeIndex statement = parseStatement();
+    if (statement == NO_NODE)
+      return NO_NODE;
+    pending.push_back(statement);
+  }
+  pos++;
+
+  size_t count;
+  NodeIndex items = closeList(start, count);
+  return tree->add(NODE_BLOCK, begin, items, static_cast<NodeIndex>(count));
+}
+
+// starts at the if or at an elif, which parses as an if nested in the else of the one before
+NodeIndex Parser::parseIf()
+{
+  if (nesting == MAX_NESTING)
+    return fail("nested too deeply");
+  NestingLevel level(nesting);
+
+  size_t keyword = pos++;
+  NodeIndex condition = parseExpression();
+  if (condition == NO_NODE)
+    return NO_NODE;
+  NodeIndex then = parseStatement();
+  if (then == NO_NODE)
+    return NO_NODE;
+
+  NodeIndex otherwise = NO_NODE;
+  if (atReserved(ReservedWord::ELIF))
+  {
+    otherwise = parseIf();
+    if (otherwise == NO_NODE)
+      return NO_NODE;
+  }
+  else if (atReserved(ReservedWord::ELSE))
+  {
+    pos++;
+    otherwise = parseStatement();
+    if (otherwise == NO_NODE)
+      return NO_NODE;
+  }
+
+  return tree->add(NODE_IF, keyword, condition, then, otherwise);
+}
+
+NodeIndex Parser::parseWhile()
+{
+  size_t keyword = pos++;
+  NodeIndex condition = parseExpression();
+  if (condition == NO_NODE)
+    return NO_NODE;
+  NodeIndex body = parseStatement();
+  if (body == NO_NODE)
+    return NO_NODE;
+  return tree->add(NODE_WHILE, keyword, condition, body);
+}
+
+NodeIndex Parser::parseFor()
+{
+  size_t keyword = pos++;
+  if (!at(LEFT_RND_BRACKET))
+    return fail("expected ( after for");
+  pos++;
+
+  NodeIndex init = NO_NODE;
+  if (!at(SEMICOLON) && (init = parseSimple()) == NO_NODE)
+    return NO_NODE;
+  if (!at(SEMICOLON))
+    return fail("expected ; after the initialization of a for");
+  pos++;
+
+  NodeIndex condition = NO_NODE;
+  if (!at(SEMICOLON) && (condition = parseExpression()) == NO_NODE)
+    return NO_NODE;
+  if (!at(SEMICOLON))
+    return fail("expected ; after the condition of a for");
+  pos++;
+
+  NodeIndex step = NO_NODE;
+  if (!at(RIGHT_RND_BRACKET) && (step = parseSimple()) == NO_NODE)
+    return NO_NODE;
+  if (!at(RIGHT_RND_BRACKET))
+    return fail("expected ) after the step of a for");
+  pos++;
+
+  NodeIndex body = parseStatement();
+  if (body == NO_NODE)
+    return NO_NODE;
+  return tree->add(NODE_FOR, keyword, init, condition, step, body);
+}
+
+NodeIndex Parser::parseSimple()
+{
+  // a statement can't usefully be a lone name, so two names in a row start a declaration
+  if (at(IDENTIFIER) && has(pos + 1) && tokens[pos + 1].getType() == IDENTIFIER)
+  {
+    size_t type = pos;
+    NodeIndex name = tree->add(NODE_NAME, pos + 1);
+    pos += 2;
+
+    NodeIndex value = NO_NODE;
+    if (at(ASSIGNMENT))
+    {
+      pos++;
+      value = parseExpression();
+      if (value == NO_NODE)
+        return NO_NODE;
+    }
+    return tree->add(NODE_DECLARATION, type, name, value);
+  }
+
+  NodeIndex target = parseExpression();
+  if (target == NO_NODE || !at(ASSIGNMENT))
+    return target;
+
+  NodeKind kind = tree->getKind(target);
+  if (kind != NODE_NAME && kind != NODE_INDEX)
+    return fail("only a name or an indexed element can be assigned to");
+
+  size_t assignment = pos++;
+  NodeIndex value = parseExpression();
+  if (value == NO_NODE)
+    return NO_NODE;
+  return tree->add(NODE_ASSIGNMENT, assignment, target, value);
+}
+
+// binary operators binding tighter than minPrecedence, left to right
+NodeIndex Parser::parseExpression(int minPrecedence)
+{
+  NodeIndex left = parseUnary();
+  while (left != NO_NODE && !atEnd())
+  {
+    int precedence = getPrecedence(tokens[pos]);
+    if (precedence <= minPrecedence)
+      break;
+
+    size_t op = pos++;
+    NodeIndex right = parseExpression(precedence);
+    if (right == NO_NODE)
+      return NO_NODE;
+    left = tree->add(NODE_BINARY, op, left, right);
+  }
+  return left;
+}
+
+NodeIndex Parser::parseUnary()
+{
+  if (atEnd())
+    return fail("expected an expression");
+  if (nesting == MAX_NESTING)
+    return fail("nested too deeply");
+  NestingLevel level(nesting);
+
+  TokenRef token = tokens[pos];
+  switch (token.getType())
+  {
+  case ARITHMETIC:
+    if (token.getSubtype() != Arithmetic::PLUS && token.getSubtype() != Arithmetic::MINUS)
+      break;
+    // fall through
+  case LOGIC_NOT:
+  case BITWISE_NOT:
+    {
+      size_t op = pos++;
+      NodeIndex operand = parseUnary();
+      if (operand == NO_NODE)
+        return NO_NODE;
+      return tree->add(NODE_UNARY, op, operand);
+    }
+  case INTEGER:
+  case FLOAT:
+  case LITERAL:
+  case BOOL:
+    return tree->add(NODE_CONSTANT, pos++);
+  case IDENTIFIER:
+    return parsePostfix(tree->add(NODE_NAME, pos++));
+  case LEFT_RND_BRACKET:
+    {
+      pos++;
+      NodeIndex inner = parseExpression();
+      if (inner == NO_NODE)
+        return NO_NODE;
+      if (!at(RIGHT_RND_BRACKET))
+        return fail("expected )");
+      pos++;
+      return parsePostfix(inner);
+    }
+  default:
+    break;
+  }
+  return fail("expected an expression");
+}
+
+NodeIndex Parser::parsePostfix(NodeIndex node)
+{
+  while (node != NO_NODE)
+  {
+    if (at(LEFT_RND_BRACKET))
+      node = parseCall(node);
+    else if (at(LEFT_SQR_BRACKET))
+    {
+      size_t bracket = pos++;
+      NodeIndex index = parseExpression();
+      if (index == NO_NODE)
+        return NO_NODE;
+      if (!at(RIGHT_SQR_BRACKET))
+        return fail("expected ]");
+      pos++;
+      node = tree->add(NODE_INDEX, bracket, node, index);
+    }
+    else
+      break;
+  }
+  return node;
+}
+
+NodeIndex Parser::parseCall(NodeIndex callee)
+{
+  size_t bracket = pos++;
+  size_t start = pending.size();
+
+  if (!at(RIGHT_RND_BRACKET))
+  {
+    while (true)
+    {
+      NodeIndex argument = parseExpression();
+      if (argument == NO_NODE)
+        return NO_NODE;
+      pending.push_back(argument);
+      if (!at(COMMA))
+        break;
+      pos++;
+    }
+    if (!at(RIGHT_RND_BRACKET))
+      return fail("expected , or ) in the arguments of a call");
+  }
+  pos++;
+
+  size_t count;
+  NodeIndex items = closeList(start, count);
+  return tree->add(NODE_CALL, bracket, callee, items, static_cast<NodeIndex>(count));
+}
+
+// 0 for anything that isn't a binary operator
+int Parser::getPrecedence(const TokenRef &token)
+{
+  int subtype = token.getSubtype();
+  switch (token.getType())
+  {
+  case LOGIC_BINARY:
+    if (subtype == LogicBinary::OR)
+      return 1;
+    return (subtype == LogicBinary::XOR) ? 2 : 3;
+  case BITWISE_BINARY:
+    if (subtype == BitwiseBinary::OR)
+      return 4;
+    return (subtype == BitwiseBinary::XOR) ? 5 : 6;
+  case COMPARISON:
+    return (subtype == Comparison::EQ || subtype == Comparison::NEQ) ? 7 : 8;
+  case SHIFT:
+    return 9;
+  case ARITHMETIC:
+    return (subtype == Arithmetic::PLUS || subtype == Arithmetic::MINUS) ? 10 : 11;
+  default:
+    return 0;
+  }
+}
+
+_LEX_END
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include "TokenStream.h"
+#include "Syntax.h"
+#include "TokenRing.h"
+
+_LEX_BEGIN
+
+// recursive descent over statements, precedence climbing over expressions:
+//
+//   program    = { statement }
+//   statement  = "begin" { statement } "end"
+//              | "if" expression statement { "elif" expression statement } [ "else" statement ]
+//              | "while" expression statement
+//              | "for" "(" [ simple ] ";" [ expression ] ";" [ simple ] ")" statement
+//              | simple [ ";" ]
+//              | ";"
+//   simple     = name name [ "=" expression ]       declaration with a type name
+//              | expression [ "=" expression ]      assignment to a name or an index
+//
+// from loosest to tightest the binary operators are ||, logic xor, &&, |, ^, &, == !=,
+// < <= > >=, << >>, + -, * / %, all left associative; then the unary - + ! ~, then calls
+// and indexing. Statements need no separator, an expression ends where the next token
+// can't continue it. Every level of the recursion takes stack, so brackets, unary operators,
+// statements and elifs nested more than MAX_NESTING deep in one another are a parse error
+class Parser
+{
+public:
+  explicit Parser(const TokenView &tokens);
+  // consumer side of a pipeline: tokens are moved from the ring into stream, which must be
+  // empty and have its source set, as the parser gets to them; parse stops the ring when done
+  Parser(TokenRing &ring, TokenStream &stream);
+
+  // false if the stream isn't a program, the tree then holds whatever was parsed
+  bool parse(Syntax &tree);
+
+  size_t getErrorToken() const { return errorToken; } // stream index, size() for the end
+  const char *getError() const { return error; }
+
+  // a few hundred bytes of stack each, deep enough for any program written by hand
+  static const unsigned MAX_NESTING = 256;
+
+private:
+  Parser(const Parser &);
+  Parser &operator=(const Parser &);
+
+  TokenView tokens;
+  TokenRing *ring;
+  TokenStream *stream;
+  size_t pos;
+  Syntax *tree;
+  std::vector<NodeIndex> pending;  // items of the lists being parsed, innermost last
+  unsigned nesting;                // levels of parseStatement, parseIf and parseUnary in progress
+  size_t errorToken;
+  const char *error;
+
+  bool has(size_t i) { return i < tokens.size() || (ring && pull(i)); }
+  bool pull(size_t i);
+  bool atEnd() { return !has(pos); }
+  bool at(TokenType type) { return has(pos) && tokens[pos].getType() == type; }
+  bool atReserved(ReservedWord::ReservedType word);
+  NodeIndex fail(const char *message);
+
+  bool parseProgram();
+  NodeIndex parseStatement();
+  NodeIndex parseBlock();
+  NodeIndex parseIf();
+  NodeIndex parseWhile();
+  NodeIndex parseFor();
+  NodeIndex parseSimple();
+
+  NodeIndex parseExpression(int minPrecedence = 0);
+  NodeIndex parseUnary();
+  NodeIndex parsePostfix(NodeIndex node);
+  NodeIndex parseCall(NodeIndex callee);
+  NodeIndex closeList(size_t start, size_t &count);
+
+  static int getPrecedence(const TokenRef &token);
+};
+
+_LEX_END
@@ -0,0 +1,224 @@
+#include <cstring>
+#include "Scanner.h"
+
+_LEX_BEGIN
+
+ScannerTables::ScannerTables()
+{
+  memset(charClass, CC_OTHER, sizeof(charClass));
+  memset(next, S_DEAD, sizeof(next));
+  memset(acceptType, -1, sizeof(acceptType));
+  memset(acceptSubtype, 0, sizeof(acceptSubtype));
+
+  for (int c = 'a'; c <= 'z'; c++)
+    charClass[c] = CC_LETTER;
+  for (int c = 'A'; c <= 'Z'; c++)
+    charClass[c] = CC_LETTER;
+  for (int c = 0x80; c <= 0xFF; c++)
+    charClass[c] = CC_UTF8;
+
+  charClass[0] = CC_NUL;
+  setClass("_", CC_LETTER);
+  setClass("0", CC_ZERO);
+  setClass("1", CC_ONE);
+  setClass("23", CC_TWO_THREE);
+  setClass("4567", CC_FOUR_SEVEN);
+  setClass("89", CC_EIGHT_NINE);
+  setClass("acABC", CC_HEX_LETTER);
+  setClass("dD", CC_D);
+  setClass("fF", CC_F);
+  setClass("b", CC_B);
+  setClass("eE", CC_E);
+  setClass("x", CC_X);
+  setClass("o", CC_O);
+  setClass("q", CC_Q);
+  setClass(".", CC_DOT);
+  setClass("\"", CC_QUOTE);
+  setClass("\\", CC_BACKSLASH);
+  setClass("<", CC_LESS);
+  setClass(">", CC_GREATER);
+  setClass("=", CC_EQUAL);
+  setClass("!", CC_BANG);
+  setClass("+", CC_PLUS);
+  setClass("-", CC_MINUS);
+  setClass("*", CC_STAR);
+  setClass("/", CC_SLASH);
+  setClass("%", CC_PERCENT);
+  setClass("&", CC_AMP);
+  setClass("|", CC_PIPE);
+  setClass("^", CC_CARET);
+  setClass("~", CC_TILDE);
+  setClass("(", CC_LEFT_RND);
+  setClass(")", CC_RIGHT_RND);
+  setClass("[", CC_LEFT_SQR);
+  setClass("]", CC_RIGHT_SQR);
+  setClass(";", CC_SEMICOLON);
+  setClass(",", CC_COMMA);
+
+  // identifiers; scanIdentifier decides which code points above ASCII may stand in a name
+  for (int c = CC_HEX_LETTER; c <= CC_UTF8; c++)
+  {
+    link(S_START, CharClass(c), S_IDENTIFIER);
+    link(S_IDENTIFIER, CharClass(c), S_IDENTIFIER);
+  }
+  linkDigits(S_IDENTIFIER, 10, S_IDENTIFIER);
+  accept(S_IDENTIFIER, IDENTIFIER);
+
+  // integers: 0x.., 0o.., 0q.., 0b.. and decimal
+  linkDigits(S_START, 10, S_DEC);
+  link(S_START, CC_ZERO, S_ZERO);
+  linkDigits(S_ZERO, 10, S_DEC);
+  linkDigits(S_DEC, 10, S_DEC);
+  link(S_ZERO, CC_X, S_HEX_PREFIX);
+  link(S_ZERO, CC_O, S_OCT_PREFIX);
+  link(S_ZERO, CC_Q, S_QUAT_PREFIX);
+  link(S_ZERO, CC_B, S_BIN_PREFIX);
+  linkDigits(S_HEX_PREFIX, 16, S_HEX);
+  linkDigits(S_HEX, 16, S_HEX);
+  linkDigits(S_OCT_PREFIX, 8, S_OCT);
+  linkDigits(S_OCT, 8, S_OCT);
+  linkDigits(S_QUAT_PREFIX, 4, S_QUAT);
+  linkDigits(S_QUAT, 4, S_QUAT);
+  linkDigits(S_BIN_PREFIX, 2, S_BIN);
+  linkDigits(S_BIN, 2, S_BIN);
+  accept(S_ZERO, INTEGER, 10);
+  accept(S_DEC, INTEGER, 10);
+  accept(S_HEX, INTEGER, 16);
+  accept(S_OCT, INTEGER, 8);
+  accept(S_QUAT, INTEGER, 4);
+  accept(S_BIN, INTEGER, 2);
+
+  // floats: digits [. digits] [e [+-] digits] [f | d], no suffix is f
+  link(S_ZERO, CC_DOT, S_FRACTION);
+  link(S_DEC, CC_DOT, S_FRACTION);
+  linkDigits(S_FRACTION, 10, S_FRACTION);
+  link(S_ZERO, CC_E, S_EXP_MARK);
+  link(S_DEC, CC_E, S_EXP_MARK);
+  link(S_FRACTION, CC_E, S_EXP_MARK);
+  link(S_EXP_MARK, CC_PLUS, S_EXP_SIGN);
+  link(S_EXP_MARK, CC_MINUS, S_EXP_SIGN);
+  linkDigits(S_EXP_MARK, 10, S_EXPONENT);
+  linkDigits(S_EXP_SIGN, 10, S_EXPONENT);
+  linkDigits(S_EXPONENT, 10, S_EXPONENT);
+  link(S_FRACTION, CC_F, S_FLOAT_SUFFIX);
+  link(S_EXPONENT, CC_F, S_FLOAT_SUFFIX);
+  link(S_FRACTION, CC_D, S_DOUBLE_SUFFIX);
+  link(S_EXPONENT, CC_D, S_DOUBLE_SUFFIX);
+  accept(S_FRACTION, FLOAT, Float::SINGLE);
+  accept(S_EXPONENT, FLOAT, Float::SINGLE);
+  accept(S_FLOAT_SUFFIX, FLOAT, Float::SINGLE);
+  accept(S_DOUBLE_SUFFIX, FLOAT, Float::DOUBLE);
+
+  // string literals, any character but \0 may be escaped
+  link(S_START, CC_QUOTE, S_STRING);
+  linkAll(S_STRING, S_STRING);
+  link(S_STRING, CC_QUOTE, S_STRING_END);
+  link(S_STRING, CC_BACKSLASH, S_STRING_ESCAPE);
+  linkAll(S_STRING_ESCAPE, S_STRING);
+  accept(S_STRING_END, LITERAL, Literal::PLAIN);
+
+  // operators and punctuation
+  link(S_START, CC_LESS, S_LESS);
+  link(S_LESS, CC_EQUAL, S_LEQ);
+  link(S_LESS, CC_LESS, S_SHL);
+  link(S_START, CC_GREATER, S_GREATER);
+  link(S_GREATER, CC_EQUAL, S_GREQ);
+  link(S_GREATER, CC_GREATER, S_SHR);
+  link(S_START, CC_EQUAL, S_ASSIGN);
+  link(S_ASSIGN, CC_EQUAL, S_EQ);
+  link(S_START, CC_BANG, S_BANG);
+  link(S_BANG, CC_EQUAL, S_NEQ);
+  link(S_START, CC_PLUS, S_PLUS);
+  link(S_START, CC_MINUS, S_MINUS);
+  link(S_START, CC_STAR, S_MUL);
+  link(S_START, CC_SLASH, S_DIV);
+  link(S_START, CC_PERCENT, S_MOD);
+  link(S_START, CC_AMP, S_AMP);
+  link(S_AMP, CC_AMP, S_LOGIC_AND);
+  link(S_START, CC_PIPE, S_PIPE);
+  link(S_PIPE, CC_PIPE, S_LOGIC_OR);
+  link(S_START, CC_CARET, S_CARET);
+  link(S_START, CC_TILDE, S_TILDE);
+  link(S_START, CC_LEFT_RND, S_LEFT_RND);
+  link(S_START, CC_RIGHT_RND, S_RIGHT_RND);
+  link(S_START, CC_LEFT_SQR, S_LEFT_SQR);
+  link(S_START, CC_RIGHT_SQR, S_RIGHT_SQR);
+  link(S_START, CC_SEMICOLON, S_SEMICOLON);
+  link(S_START, CC_COMMA, S_COMMA);
+
+  accept(S_LESS, COMPARISON, Comparison::LESS);
+  accept(S_LEQ, COMPARISON, Comparison::LEQ);
+  accept(S_GREATER, COMPARISON, Comparison::GRE);
+  accept(S_GREQ, COMPARISON, Comparison::GREQ);
+  accept(S_EQ, COMPARISON, Comparison::EQ);
+  accept(S_NEQ, COMPARISON, Comparison::NEQ);
+  accept(S_SHL, SHIFT, Shift::LEFT);
+  accept(S_SHR, SHIFT, Shift::RIGHT);
+  accept(S_ASSIGN, ASSIGNMENT);
+  accept(S_BANG, LOGIC_NOT);
+  accept(S_PLUS, ARITHMETIC, Arithmetic::PLUS);
+  accept(S_MINUS, ARITHMETIC, Arithmetic::MINUS);
+  accept(S_MUL, ARITHMETIC, Arithmetic::MUL);
+  accept(S_DIV, ARITHMETIC, Arithmetic::DIV);
+  accept(S_MOD, ARITHMETIC, Arithmetic::MOD);
+  accept(S_AMP, BITWISE_BINARY, BitwiseBinary::AND);
+  accept(S_PIPE, BITWISE_BINARY, BitwiseBinary::OR);
+  accept(S_CARET, BITWISE_BINARY, BitwiseBinary::XOR);
+  accept(S_LOGIC_AND, LOGIC_BINARY, LogicBinary::AND);
+  accept(S_LOGIC_OR, LOGIC_BINARY, LogicBinary::OR);
+  accept(S_TILDE, BITWISE_NOT);
+  accept(S_LEFT_RND, LEFT_RND_BRACKET);
+  accept(S_RIGHT_RND, RIGHT_RND_BRACKET);
+  accept(S_LEFT_SQR, LEFT_SQR_BRACKET);
+  accept(S_RIGHT_SQR, RIGHT_SQR_BRACKET);
+  accept(S_SEMICOLON, SEMICOLON);
+  accept(S_COMMA, COMMA);
+}
+
+void ScannerTables::setClass(const char *chars, CharClass c)
+{
+  for (; *chars; chars++)
+    charClass[static_cast<unsigned char>(*chars)] = c;
+}
+
+void ScannerTables::link(ScanState from, CharClass c, ScanState to)
+{
+  next[from][c] = to;
+}
+
+void ScannerTables::linkDigits(ScanState from, int base, ScanState to)
+{
+  link(from, CC_ZERO, to);
+  link(from, CC_ONE, to);
+  if (base >= 4)
+    link(from, CC_TWO_THREE, to);
+  if (base >= 8)
+    link(from, CC_FOUR_SEVEN, to);
+  if (base >= 10)
+    link(from, CC_EIGHT_NINE, to);
+  if (base >= 16)
+  {
+    link(from, CC_HEX_LETTER, to);
+    link(from, CC_D, to);
+    link(from, CC_F, to);
+    link(from, CC_B, to);
+    link(from, CC_E, to);
+  }
+}
+
+void ScannerTables::linkAll(ScanState from, ScanState to)
+{
+  for (int c = 0; c < CHAR_CLASS_COUNT; c++)
+  {
+    if (c != CC_NUL)
+      link(from, CharClass(c), to);
+  }
+}
+
+void ScannerTables::accept(ScanState s, TokenType type, int subtype)
+{
+  acceptType[s] = static_cast<signed char>(type);
+  acceptSubtype[s] = static_cast<unsigned char>(subtype);
+}
+
+_LEX_END
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "Token.h"
+
+_LEX_BEGIN
+
+// plain value produced by one scan; converted to a heap Token only on request
+struct Lexeme
+{
+  TokenType type;
+  int subtype;
+  uint32_t offset;
+  uint32_t length;
+  union
+  {
+    int intValue;
+    float floatValue;
+    double doubleValue;
+    bool boolValue;
+    size_t symbolIndex;
+  };
+  uint32_t scope;  // scope an identifier's symbol was bound in
+};
+
+// characters which the automaton never has to tell apart share one class
+enum CharClass
+{
+  CC_OTHER,
+  CC_NUL,
+  CC_ZERO,
+  CC_ONE,
+  CC_TWO_THREE,
+  CC_FOUR_SEVEN,
+  CC_EIGHT_NINE,
+  CC_HEX_LETTER,  // a, c and their capitals, plus B
+  CC_D,           // double suffix, also a hex digit
+  CC_F,           // float suffix, also a hex digit
+  CC_B,           // binary prefix, also a hex digit
+  CC_E,           // exponent mark, also a hex digit
+  CC_X,
+  CC_O,
+  CC_Q,
+  CC_LETTER,      // any other letter or _
+  CC_UTF8,        // a byte above 0x7F, outside literals only ever part of a name
+  CC_DOT,
+  CC_QUOTE,
+  CC_BACKSLASH,
+  CC_LESS,
+  CC_GREATER,
+  CC_EQUAL,
+  CC_BANG,
+  CC_PLUS,
+  CC_MINUS,
+  CC_STAR,
+  CC_SLASH,
+  CC_PERCENT,
+  CC_AMP,
+  CC_PIPE,
+  CC_CARET,
+  CC_TILDE,
+  CC_LEFT_RND,
+  CC_RIGHT_RND,
+  CC_LEFT_SQR,
+  CC_RIGHT_SQR,
+  CC_SEMICOLON,
+  CC_COMMA,
+
+  CHAR_CLASS_COUNT
+};
+
+enum ScanState
+{
+  S_DEAD,
+  S_START,
+
+  S_IDENTIFIER,
+
+  S_ZERO,
+  S_DEC,
+  S_HEX_PREFIX,
+  S_HEX,
+  S_OCT_PREFIX,
+  S_OCT,
+  S_QUAT_PREFIX,
+  S_QUAT,
+  S_BIN_PREFIX,
+  S_BIN,
+  S_FRACTION,
+  S_EXP_MARK,
+  S_EXP_SIGN,
+  S_EXPONENT,
+  S_FLOAT_SUFFIX,
+  S_DOUBLE_SUFFIX,
+
+  S_STRING,
+  S_STRING_ESCAPE,
+  S_STRING_END,
+
+  S_LESS,
+  S_LEQ,
+  S_SHL,
+  S_GREATER,
+  S_GREQ,
+  S_SHR,
+  S_ASSIGN,
+  S_EQ,
+  S_BANG,
+  S_NEQ,
+  S_PLUS,
+  S_MINUS,
+  S_MUL,
+  S_DIV,
+  S_MOD,
+  S_AMP,
+  S_LOGIC_AND,
+  S_PIPE,
+  S_LOGIC_OR,
+  S_CARET,
+  S_TILDE,
+  S_LEFT_RND,
+  S_RIGHT_RND,
+  S_LEFT_SQR,
+  S_RIGHT_SQR,
+  S_SEMICOLON,
+  S_COMMA,
+
+  SCAN_STATE_COUNT
+};
+
+// furthest the automaton reads past the end of an accepted lexeme: up to two characters of
+// a longer lexeme that never completes ("1e+", "0x") plus the one it dies on
+const size_t MAX_LOOKAHEAD = 3;
+
+// transition and acceptance tables of the deterministic scanner
+struct ScannerTables
+{
+  ScannerTables();
+
+  bool isAccepting(unsigned char state) const { return acceptType[state] >= 0; }
+
+  unsigned char charClass[256];
+  unsigned char next[SCAN_STATE_COUNT][CHAR_CLASS_COUNT];
+  signed char acceptType[SCAN_STATE_COUNT];    // TokenType, -1 if not accepting
+  unsigned char acceptSubtype[SCAN_STATE_COUNT];
+
+private:
+  void setClass(const char *chars, CharClass c);
+  void link(ScanState from, CharClass c, ScanState to);
+  void linkDigits(ScanState from, int base, ScanState to);
+  void linkAll(ScanState from, ScanState to);
+  void accept(ScanState s, TokenType type, int subtype = 0);
+};
+
+_LEX_END
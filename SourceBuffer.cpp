@@ -0,0 +1,185 @@
+#include <cstdio>
+#include <cstring>
+#include "SourceBuffer.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+_LEX_BEGIN
+
+static const char emptySource[1] = { 0 };
+
+SourceBuffer::SourceBuffer() : text(emptySource), length(0), mapping(nullptr), mappingSize(0)
+{
+}
+
+SourceBuffer::~SourceBuffer()
+{
+  release();
+}
+
+void SourceBuffer::release()
+{
+  if (mapping != nullptr)
+  {
+#ifdef _WIN32
+    UnmapViewOfFile(mapping);
+#else
+    munmap(mapping, mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+  }
+  std::vector<char>().swap(owned);
+  text = emptySource;
+  length = 0;
+}
+
+void SourceBuffer::assign(const char *data, size_t size)
+{
+  release();
+  text = data;
+  length = size;
+}
+
+void SourceBuffer::copy(const char *data, size_t size)
+{
+  release();
+  owned.resize(size + 1);
+  if (size)
+    memcpy(&owned[0], data, size);
+  owned[size] = 0;
+  text = &owned[0];
+  length = size;
+}
+
+bool SourceBuffer::readFile(const char *fileName)
+{
+  FILE *f = fopen(fileName, "rb");
+  if (f == nullptr)
+    return false;
+
+  std::vector<char> buffer;
+  char chunk[1 << 16];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    buffer.insert(buffer.end(), chunk, chunk + n);
+  fclose(f);
+
+  length = buffer.size();
+  buffer.push_back(0);
+  owned.swap(buffer);
+  text = &owned[0];
+  return true;
+}
+
+#ifdef _WIN32
+
+bool SourceBuffer::mapFile(const char *fileName)
+{
+  release();
+
+  HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER fileSize;
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  if (!GetFileSizeEx(file, &fileSize))
+  {
+    CloseHandle(file);
+    return false;
+  }
+
+  size_t size = static_cast<size_t>(fileSize.QuadPart);
+  // the tail of the last page reads as zeros, which gives the sentinel; a file
+  // ending exactly on a page boundary has no tail and is read instead
+  if (size == 0 || size % info.dwPageSize == 0)
+  {
+    CloseHandle(file);
+    return size == 0 || readFile(fileName);
+  }
+
+  HANDLE fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (fileMapping == nullptr)
+    return readFile(fileName);
+
+  void *view = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(fileMapping);
+  if (view == nullptr)
+    return readFile(fileName);
+
+  mapping = view;
+  mappingSize = size;
+  text = static_cast<const char *>(view);
+  length = size;
+  return true;
+}
+
+#else
+
+bool SourceBuffer::mapFile(const char *fileName)
+{
+  release();
+
+  int fd = open(fileName, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    return false;
+  }
+
+  size_t size = static_cast<size_t>(st.st_size);
+  if (size == 0)
+  {
+    close(fd);
+    return true;
+  }
+
+  size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  void *base = MAP_FAILED;
+  size_t total = size;
+
+  if (size % page != 0)
+    base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0); // tail of the last page reads as zeros
+  else
+  {
+    // no tail to hold the sentinel: put a zero page right behind the file
+    total = size + page;
+    base = mmap(nullptr, total, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base != MAP_FAILED && mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+      munmap(base, total);
+      base = MAP_FAILED;
+    }
+  }
+  close(fd);
+
+  if (base == MAP_FAILED)
+    return readFile(fileName);
+
+  madvise(base, size, MADV_SEQUENTIAL);
+  mapping = base;
+  mappingSize = total;
+  text = static_cast<const char *>(base);
+  length = size;
+  return true;
+}
+
+#endif
+
+_LEX_END
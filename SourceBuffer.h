@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include "Token.h"
+
+_LEX_BEGIN
+
+// read-only source text which is always followed by a readable \0 sentinel
+class SourceBuffer
+{
+public:
+  SourceBuffer();
+  ~SourceBuffer();
+
+  // maps the file where the sentinel can be had for free, reads it otherwise
+  bool mapFile(const char *fileName);
+  // borrows the caller's memory, data[length] must be readable and equal to \0
+  void assign(const char *data, size_t length);
+  void copy(const char *data, size_t length);
+  void release();
+
+  const char *data() const { return text; }
+  size_t size() const { return length; }
+  bool isMapped() const { return mapping != nullptr; }
+
+private:
+  SourceBuffer(const SourceBuffer &);
+  SourceBuffer &operator=(const SourceBuffer &);
+
+  bool readFile(const char *fileName);
+
+  const char *text;
+  size_t length;
+  std::vector<char> owned;
+  void *mapping;
+  size_t mappingSize;
+};
+
+_LEX_END
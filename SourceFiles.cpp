@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include "SourceFiles.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+_LEX_BEGIN
+
+static const char SOURCE_EXTENSION[] = ".ag";
+
+static bool hasSourceExtension(const std::string &name)
+{
+  size_t length = sizeof(SOURCE_EXTENSION) - 1;
+  return name.size() > length && name.compare(name.size() - length, length, SOURCE_EXTENSION) == 0;
+}
+
+static bool isDirectory(const std::string &path)
+{
+#ifdef _WIN32
+  DWORD attributes = GetFileAttributesA(path.c_str());
+  return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+  struct stat info;
+  return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+// names in the directory without . and .., sorted so a tree gives the same list every time
+static bool listDirectory(const std::string &path, std::vector<std::string> &names)
+{
+#ifdef _WIN32
+  WIN32_FIND_DATAA entry;
+  HANDLE find = FindFirstFileA((path + "\\*").c_str(), &entry);
+  if (find == INVALID_HANDLE_VALUE)
+    return false;
+  do
+  {
+    if (strcmp(entry.cFileName, ".") && strcmp(entry.cFileName, ".."))
+      names.push_back(entry.cFileName);
+  } while (FindNextFileA(find, &entry));
+  FindClose(find);
+#else
+  DIR *directory = opendir(path.c_str());
+  if (directory == nullptr)
+    return false;
+  while (struct dirent *entry = readdir(directory))
+  {
+    if (strcmp(entry->d_name, ".") && strcmp(entry->d_name, ".."))
+      names.push_back(entry->d_name);
+  }
+  closedir(directory);
+#endif
+
+  std::sort(names.begin(), names.end());
+  return true;
+}
+
+static bool addDirectory(const std::string &path, std::vector<std::string> &files)
+{
+  std::vector<std::string> names;
+  if (!listDirectory(path, names))
+    return false;
+
+  for (size_t i = 0; i < names.size(); i++)
+  {
+    std::string child = path + '/' + names[i];
+    if (isDirectory(child))
+    {
+      if (!addDirectory(child, files))
+        return false;
+    }
+    else if (hasSourceExtension(names[i]))
+      files.push_back(child);
+  }
+  return true;
+}
+
+static bool addListed(const std::string &listName, std::vector<std::string> &files)
+{
+  std::ifstream list(listName.c_str());
+  if (!list)
+    return false;
+
+  std::string line;
+  while (std::getline(list, line))
+  {
+    size_t begin = line.find_first_not_of(" \t\r");
+    if (begin == std::string::npos)
+      continue;
+    size_t end = line.find_last_not_of(" \t\r") + 1;
+    if (!addSourceFiles(line.substr(begin, end - begin), files))
+      return false;
+  }
+  return true;
+}
+
+bool addSourceFiles(const std::string &input, std::vector<std::string> &files)
+{
+  if (!input.empty() && input[0] == '@')
+    return addListed(input.substr(1), files);
+  if (isDirectory(input))
+    return addDirectory(input, files);
+
+  files.push_back(input);
+  return true;
+}
+
+_LEX_END
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Token.h"
+
+_LEX_BEGIN
+
+// expands one command line input into the files it names, appended in a stable order:
+// a directory gives every .ag file under it, @list gives what each line of list names,
+// which may be a directory or @list again, and anything else is taken as a file;
+// false if a directory or list can't be read
+bool addSourceFiles(const std::string &input, std::vector<std::string> &files);
+
+_LEX_END
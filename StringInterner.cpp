@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <cstring>
+#include "StringInterner.h"
+#include "Bits.h"
+
+const uint32_t StringInterner::NOT_FOUND;
+
+StringInterner::StringInterner()
+{
+  Slot empty = { 0, NOT_FOUND };
+  slots.assign(256, empty);
+  mask = slots.size() - 1;
+}
+
+void StringInterner::clear()
+{
+  Slot empty = { 0, NOT_FOUND };
+  std::fill(slots.begin(), slots.end(), empty);
+  entries.clear();
+  arena.reset();
+}
+
+uint32_t StringInterner::hash(const char *name, size_t length)
+{
+  return bits::hashBytes(name, length);
+}
+
+// index of the slot holding the name, or of the empty slot where it belongs
+size_t StringInterner::probe(const char *name, size_t length, uint32_t hash) const
+{
+  size_t i = hash & mask;
+  while (true)
+  {
+    const Slot &slot = slots[i];
+    if (slot.id == NOT_FOUND)
+      return i;
+
+    if (slot.hash == hash)
+    {
+      const Entry &e = entries[slot.id];
+      if (e.length == length && !memcmp(e.name, name, length))
+        return i;
+    }
+    i = (i + 1) & mask;
+  }
+}
+
+uint32_t StringInterner::find(const char *name, size_t length, uint32_t hash) const
+{
+  return slots[probe(name, length, hash)].id;
+}
+
+uint32_t StringInterner::intern(const char *name, size_t length, uint32_t hash)
+{
+  size_t i = probe(name, length, hash);
+  if (slots[i].id != NOT_FOUND)
+    return slots[i].id;
+
+  Entry e;
+  e.name = arena.copy(name, length);
+  e.length = static_cast<uint32_t>(length);
+  e.hash = hash;
+
+  uint32_t id = static_cast<uint32_t>(entries.size());
+  entries.push_back(e);
+  slots[i].hash = hash;
+  slots[i].id = id;
+
+  if (entries.size() * 2 > slots.size()) // keep the load factor under one half
+    grow();
+  return id;
+}
+
+void StringInterner::grow()
+{
+  Slot empty = { 0, NOT_FOUND };
+  std::vector<Slot> bigger(slots.size() * 2, empty);
+  mask = bigger.size() - 1;
+
+  for (size_t id = 0; id < entries.size(); id++)
+  {
+    size_t i = entries[id].hash & mask;
+    while (bigger[i].id != NOT_FOUND)
+      i = (i + 1) & mask;
+    bigger[i].hash = entries[id].hash;
+    bigger[i].id = static_cast<uint32_t>(id);
+  }
+  slots.swap(bigger);
+}
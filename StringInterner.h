@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "Arena.h"
+
+// keeps one arena copy of every distinct name and hands out dense 32-bit ids
+class StringInterner
+{
+public:
+  static const uint32_t NOT_FOUND = 0xFFFFFFFF;
+
+  StringInterner();
+
+  static uint32_t hash(const char *name, size_t length);
+
+  // hash must be StringInterner::hash of the name, the lexer computes it while scanning
+  uint32_t intern(const char *name, size_t length, uint32_t hash);
+  uint32_t intern(const char *name, size_t length) { return intern(name, length, hash(name, length)); }
+  uint32_t find(const char *name, size_t length, uint32_t hash) const;
+  uint32_t find(const char *name, size_t length) const { return find(name, length, hash(name, length)); }
+
+  const char *getName(uint32_t id) const { return entries[id].name; }
+  size_t getLength(uint32_t id) const { return entries[id].length; }
+  size_t size() const { return entries.size(); }
+
+  // forgets every name, ids start at 0 again; the arena chunks and the slots are kept
+  void clear();
+
+private:
+  StringInterner(const StringInterner &);
+  StringInterner &operator=(const StringInterner &);
+
+  struct Entry
+  {
+    const char *name;
+    uint32_t length;
+    uint32_t hash;
+  };
+
+  struct Slot
+  {
+    uint32_t hash;
+    uint32_t id;  // NOT_FOUND marks an empty slot
+  };
+
+  Arena arena;
+  std::vector<Entry> entries;
+  std::vector<Slot> slots;   // open addressing with linear probing, size is a power of two
+  size_t mask;
+
+  size_t probe(const char *name, size_t length, uint32_t hash) const;
+  void grow();
+};
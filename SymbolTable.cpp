@@ -1,4 +1,64 @@
 #include "SymbolTable.h"
 
-std::set<std::string> SymbolTable::s_reservedNames;
-bool SymbolTable::reservedInited = false;
\ No newline at end of file
+const uint32_t ScopedSymbolTable::NOT_FOUND;
+
+ScopedSymbolTable::ScopedSymbolTable(StringInterner *interner) : interner(interner)
+{
+  clear();
+}
+
+void ScopedSymbolTable::clear()
+{
+  symbols.clear();
+  innermost.clear();
+  undoLog.clear();
+  open.clear();
+
+  OpenScope outermost = { 0, 0 };
+  open.push_back(outermost);
+  scopeCount = 1;
+}
+
+void ScopedSymbolTable::enterScope()
+{
+  OpenScope scope = { scopeCount++, undoLog.size() };
+  open.push_back(scope);
+}
+
+bool ScopedSymbolTable::exitScope()
+{
+  if (open.size() == 1)
+    return false;
+
+  size_t start = open.back().undoStart;
+  while (undoLog.size() > start)
+  {
+    const Symbol &symbol = symbols[undoLog.back()];
+    innermost[symbol.data.nameId] = symbol.shadowed;
+    undoLog.pop_back();
+  }
+  open.pop_back();
+  return true;
+}
+
+uint32_t ScopedSymbolTable::put(DataType type, uint32_t nameId)
+{
+  if (nameId >= innermost.size())
+    innermost.resize(nameId + 1, NOT_FOUND);
+
+  uint32_t shadowed = innermost[nameId];
+  uint32_t scope = getScope();
+  if (shadowed != NOT_FOUND && symbols[shadowed].scope == scope)
+    return shadowed;
+
+  Symbol symbol;
+  symbol.data = SymbolData(type, nameId);
+  symbol.scope = scope;
+  symbol.shadowed = shadowed;
+
+  uint32_t id = static_cast<uint32_t>(symbols.size());
+  symbols.push_back(symbol);
+  innermost[nameId] = id;
+  undoLog.push_back(id);
+  return id;
+}
@@ -1,9 +1,9 @@
 #pragma once
 
 #include <vector>
-#include <map>
 #include <string>
-#include <set>
+#include <cstdint>
+#include "StringInterner.h"
 
 enum DataType
 {
@@ -18,112 +18,72 @@ enum DataType
 
 struct SymbolData
 {
-  SymbolData() : type(DataType::NON_EXIST) {}
-  SymbolData(DataType type, const std::string &name) : type(type), name(name) {}
-  
+  SymbolData() : type(DataType::NON_EXIST), nameId(StringInterner::NOT_FOUND) {}
+  SymbolData(DataType type, uint32_t nameId) : type(type), nameId(nameId) {}
+
   operator bool() { return type != DataType::NON_EXIST; }
 
-  std::string name;
   DataType type;
+  uint32_t nameId;
 };
 
-class SymbolTable
+// the names of all open scopes in one table: each interned name id leads to its innermost
+// binding, which links to the binding it shadows. Closing a scope unbinds what it declared
+// by replaying its part of the undo log, so lookups cost the same at any nesting depth
+class ScopedSymbolTable
 {
 public:
-  static const size_t s_reservedWordsNumber = 7;
-  static std::set<std::string> s_reservedNames;
+  static const uint32_t NOT_FOUND = 0xFFFFFFFF;
 
-  static bool isReservedWord(const std::string &name)
-  {
-    return (s_reservedNames.find(name) != s_reservedNames.end());
-  }
+  explicit ScopedSymbolTable(StringInterner *interner);
 
-  SymbolTable() : parent(nullptr) 
-  {
-    if (!reservedInited)
-      initTable();
-  }
+  void enterScope();
+  bool exitScope(); // false if only the outermost scope is open
+  uint32_t getScope() const { return open.back().scope; }
+  size_t getDepth() const { return open.size() - 1; }
 
-  SymbolTable(SymbolTable *parent) : parent(parent) 
+  // binds the name in the current scope unless it is bound there already and returns the
+  // symbol; symbol ids stay valid after their scope is closed
+  uint32_t put(DataType type, uint32_t nameId);
+  // hash is StringInterner::hash of the name
+  uint32_t put(DataType type, const char *name, size_t length, uint32_t hash)
   {
-    if (!reservedInited)
-      initTable();
+    return put(type, interner->intern(name, length, hash));
   }
 
-
-  int put(const SymbolData &data)
+  // innermost binding of the name, or NOT_FOUND
+  uint32_t find(uint32_t nameId) const
   {
-    if (isReservedWord(data.name))
-      return -1;
-
-    if (contains(data.name))
-      return names[data.name];
-
-    table.push_back(data);
-
-    int index = table.size() - 1;
-    names[data.name] = index;
-    return index;
+    return (nameId < innermost.size()) ? innermost[nameId] : NOT_FOUND;
   }
-  
-  SymbolData getFromCurrentScope(const std::string &name) 
-  { 
-    if (contains(name))
-      return table[names[name]];
-    return SymbolData(NON_EXIST, "");
-  }
-  
-  SymbolData getFromCurrentScope(size_t index) 
-  { 
-    if (index >= 0 && index < table.size())
-      return table[index]; 
-    return SymbolData(NON_EXIST, "");
-  }
-  
-  SymbolData getFromAnyClosestScope(const std::string &name)
-  {
-    SymbolTable *tbl = this;
+  uint32_t find(const std::string &name) const { return find(interner->find(name.c_str(), name.size())); }
 
-    do 
-    {
-      if (tbl->contains(name))
-        return tbl->table[names[name]];
-      tbl = tbl->parent;
-    } while (tbl);
-    return SymbolData(NON_EXIST, "");
-  }
-
-  bool contains(const std::string &name) { return (names.find(name) != names.end()); }
-
-  int getIndex(const SymbolData &data)
-  {
-    if (contains(data.name))
-      return names[data.name];
+  const SymbolData &get(uint32_t symbol) const { return symbols[symbol].data; }
+  uint32_t getScope(uint32_t symbol) const { return symbols[symbol].scope; }
+  const char *getName(uint32_t symbol) const { return interner->getName(symbols[symbol].data.nameId); }
+  size_t getNameLength(uint32_t symbol) const { return interner->getLength(symbols[symbol].data.nameId); }
+  size_t size() const { return symbols.size(); }
 
-    return -1;
-  }
-
-  SymbolTable *getParent()
-  {
-    return parent;
-  }
+  void clear(); // leaves the outermost scope open and empty
 
 private:
-  SymbolTable *parent;
-  static bool reservedInited;
-  std::vector<SymbolData> table;
-  std::map<std::string, size_t> names;
-  
-  void initTable()
+  struct Symbol
   {
-    s_reservedNames.insert("if");
-    s_reservedNames.insert("elif");
-    s_reservedNames.insert("else");
-    s_reservedNames.insert("for");
-    s_reservedNames.insert("while");
-    s_reservedNames.insert("begin");
-    s_reservedNames.insert("end");
+    SymbolData data;
+    uint32_t scope;
+    uint32_t shadowed;  // binding of the same name this one hides, or NOT_FOUND
+  };
 
-    reservedInited = true;
-  }
-}; 
\ No newline at end of file
+  struct OpenScope
+  {
+    uint32_t scope;
+    size_t undoStart;   // undo log entries from here on were bound in this scope
+  };
+
+  StringInterner *interner;
+  std::vector<Symbol> symbols;
+  std::vector<uint32_t> innermost;  // by name id
+  std::vector<uint32_t> undoLog;
+  std::vector<OpenScope> open;
+  uint32_t scopeCount;
+};
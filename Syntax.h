@@ -1 +1,107 @@
-#pragma once
\ No newline at end of file
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "Token.h"
+#include "TokenStream.h"
+
+_LEX_BEGIN
+
+typedef uint32_t NodeIndex;
+
+const NodeIndex NO_NODE = 0xFFFFFFFF;
+
+// what a node is and what its children mean; every node also keeps the index of one token
+// of the stream it was parsed from, which holds its operator, name or value
+enum NodeKind
+{
+  NODE_BLOCK,        // begin/end or the whole program: items, count; token is begin, 0 for the program
+  NODE_IF,           // condition, then, else or NO_NODE; an elif is an if in the else slot
+  NODE_WHILE,        // condition, body
+  NODE_FOR,          // init, condition, step, body; any but the body may be NO_NODE
+  NODE_DECLARATION,  // name, initial value or NO_NODE; token is the type name
+  NODE_ASSIGNMENT,   // target, value; token is the =
+  NODE_NAME,         // token is the identifier
+  NODE_CONSTANT,     // token is an integer, float, literal or bool
+  NODE_UNARY,        // operand; token is the operator
+  NODE_BINARY,       // left, right; token is the operator
+  NODE_CALL,         // callee, items, count; token is the (
+  NODE_INDEX,        // base, index; token is the [
+  NODE_VALUE         // a constant no token holds, made by folding: value index; token is the operator folded
+};
+
+// what a NODE_VALUE stands for: an integer, a float of either subtype or a bool, the value
+// read as a token of that type would be
+struct ConstantValue
+{
+  TokenType type;
+  int subtype;
+  TokenValue value;
+};
+
+struct SyntaxNode
+{
+  uint8_t kind;
+  uint32_t token;
+  NodeIndex child[4];
+};
+
+// a whole tree in two arrays: nodes refer to each other by index, and the variable length
+// child lists of blocks and calls are runs of the list array
+class Syntax
+{
+public:
+  Syntax() : root(NO_NODE) {}
+
+  NodeIndex add(NodeKind kind, size_t token, NodeIndex a = NO_NODE, NodeIndex b = NO_NODE, NodeIndex c = NO_NODE, NodeIndex d = NO_NODE)
+  {
+    SyntaxNode node;
+    node.kind = static_cast<uint8_t>(kind);
+    node.token = static_cast<uint32_t>(token);
+    node.child[0] = a;
+    node.child[1] = b;
+    node.child[2] = c;
+    node.child[3] = d;
+    nodes.push_back(node);
+    return static_cast<NodeIndex>(nodes.size() - 1);
+  }
+
+  // copies count indices to the end of the list array and returns where they start
+  NodeIndex addList(const NodeIndex *items, size_t count)
+  {
+    NodeIndex start = static_cast<NodeIndex>(lists.size());
+    lists.insert(lists.end(), items, items + count);
+    return start;
+  }
+
+  // turns node into a NODE_VALUE in place, keeping its token; its old children are left in
+  // the arrays but nothing refers to them any more
+  void setValue(NodeIndex node, const ConstantValue &value)
+  {
+    SyntaxNode &replaced = nodes[node];
+    replaced.kind = NODE_VALUE;
+    replaced.child[0] = static_cast<NodeIndex>(values.size());
+    replaced.child[1] = replaced.child[2] = replaced.child[3] = NO_NODE;
+    values.push_back(value);
+  }
+
+  const SyntaxNode &operator[](NodeIndex i) const { return nodes[i]; }
+  NodeKind getKind(NodeIndex i) const { return static_cast<NodeKind>(nodes[i].kind); }
+  const NodeIndex *getList(NodeIndex start) const { return lists.empty() ? nullptr : &lists[0] + start; }
+  const ConstantValue &getValue(NodeIndex node) const { return values[nodes[node].child[0]]; }
+
+  NodeIndex getRoot() const { return root; }
+  void setRoot(NodeIndex node) { root = node; }
+  size_t size() const { return nodes.size(); }
+
+  void reserve(size_t nodeCount) { nodes.reserve(nodeCount); }
+  void clear() { nodes.clear(); lists.clear(); values.clear(); root = NO_NODE; } // keeps the memory for the next tree
+
+private:
+  std::vector<SyntaxNode> nodes;
+  std::vector<NodeIndex> lists;
+  std::vector<ConstantValue> values;
+  NodeIndex root;
+};
+
+_LEX_END
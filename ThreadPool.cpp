@@ -0,0 +1,113 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threadCount) : unfinished(0), stopping(false)
+{
+  if (threadCount == 0)
+    threadCount = std::thread::hardware_concurrency();
+  if (threadCount == 0)
+    threadCount = 1;
+
+  nextQueue.store(0);
+  queued.store(0);
+  for (size_t i = 0; i < threadCount; i++)
+    queues.push_back(new WorkQueue);
+  for (size_t i = 0; i < threadCount; i++)
+    workers.push_back(std::thread(&ThreadPool::run, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  jobReady.notify_all();
+
+  for (size_t i = 0; i < workers.size(); i++)
+    workers[i].join();
+  for (size_t i = 0; i < queues.size(); i++)
+    delete queues[i];
+}
+
+void ThreadPool::submit(const std::function<void()> &job)
+{
+  std::function<void()> copy = job;
+  submitIndexed([copy](size_t) { copy(); });
+}
+
+void ThreadPool::submitIndexed(const std::function<void(size_t)> &job)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    unfinished++;
+  }
+
+  WorkQueue *queue = queues[nextQueue++ % queues.size()];
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->jobs.push_back(job);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    queued++;
+  }
+  jobReady.notify_one();
+}
+
+void ThreadPool::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (unfinished != 0)
+    jobsDone.wait(lock);
+}
+
+// own queue from the back while it lasts, then the others from the front
+bool ThreadPool::takeJob(size_t worker, Job &job)
+{
+  for (size_t i = 0; i < queues.size(); i++)
+  {
+    WorkQueue *queue = queues[(worker + i) % queues.size()];
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->jobs.empty())
+      continue;
+
+    if (i == 0)
+    {
+      job = queue->jobs.back();
+      queue->jobs.pop_back();
+    }
+    else
+    {
+      job = queue->jobs.front();
+      queue->jobs.pop_front();
+    }
+    queued--;
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::run(size_t worker)
+{
+  while (true)
+  {
+    Job job;
+    if (!takeJob(worker, job))
+    {
+      // queued only grows under the mutex, so a job submitted after this check wakes us
+      std::unique_lock<std::mutex> lock(mutex);
+      while (queued <= 0 && !stopping)
+        jobReady.wait(lock);
+      if (queued <= 0)
+        return;
+      continue;
+    }
+
+    job(worker);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--unfinished == 0)
+      jobsDone.notify_all();
+  }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <deque>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// fixed set of worker threads, each with a queue of its own: jobs are dealt out to the
+// queues in turn, a worker takes the newest job of its own queue and, once that is empty,
+// steals the oldest job of another, so a few long jobs don't leave the other workers idle
+class ThreadPool
+{
+public:
+  explicit ThreadPool(size_t threadCount = 0); // 0 starts one thread per hardware thread
+  ~ThreadPool();
+
+  void submit(const std::function<void()> &job);
+  // the job is told the index of the worker running it, below size(), to pick per worker state
+  void submitIndexed(const std::function<void(size_t)> &job);
+  void wait(); // blocks until every submitted job has run
+
+  size_t size() const { return workers.size(); }
+
+private:
+  ThreadPool(const ThreadPool &);
+  ThreadPool &operator=(const ThreadPool &);
+
+  typedef std::function<void(size_t)> Job;
+
+  struct WorkQueue
+  {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+  };
+
+  void run(size_t worker);
+  bool takeJob(size_t worker, Job &job);
+
+  std::vector<std::thread> workers;
+  std::vector<WorkQueue *> queues;    // one per worker
+  std::atomic<size_t> nextQueue;
+  std::atomic<ptrdiff_t> queued;      // jobs in all queues; a job taken before its submit counted it makes this -1 for a moment
+  std::mutex mutex;
+  std::condition_variable jobReady;
+  std::condition_variable jobsDone;
+  size_t unfinished;
+  bool stopping;
+};
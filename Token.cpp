@@ -3,14 +3,16 @@
 
 _LEX_BEGIN
 
-CharToDigit::CharToDigit()
+// isspace of a byte above 0x7F is undefined for a signed char
+static inline bool isBlank(char c)
 {
-  for (char c = '0'; c < '9'; c++)
-    charToDigit[c] = c - '0';
-  for (char c = 'a'; c < 'f'; c++)
-    charToDigit[c] = 10 + c - 'a';
-  for (char c = 'A'; c < 'F'; c++)
-    charToDigit[c] = 10 + c - 'A';
+  return isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+// part of a UTF-8 sequence, which after an operator or a bracket can only start a name
+static inline bool isNameByte(char c)
+{
+  return static_cast<unsigned char>(c) >= 0x80;
 }
 
 bool Operand::isCharacterPossibleAfterToken(char c)
@@ -39,17 +41,32 @@ bool Operand::isCharacterPossibleAfterToken(char c)
     break;
   }
 
-  return (isOk || isspace(c));
+  return (isOk || isBlank(c));
 }
 
+// an operand, or the unary operators and the bracket that can start one
 bool Operator::isCharacterPossibleAfterToken(char c)
 {
-  return ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (c >= '0' && c <= '9') || isspace(c));
+  bool isOk = ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (c >= '0' && c <= '9') || isNameByte(c) || isBlank(c));
+
+  switch (c)
+  {
+  case '+':
+  case '-':
+  case '!':
+  case '~':
+  case '(':
+  case '"':
+    isOk = true;
+    break;
+  }
+
+  return isOk;
 }
 
 bool ReservedWord::isCharacterPossibleAfterToken(char c)
 {
-  bool isOk = ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (c >= '0' && c <= '9') || isspace(c));
+  bool isOk = ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (c >= '0' && c <= '9') || isNameByte(c) || isBlank(c));
 
   switch (c)
   {
@@ -64,15 +81,21 @@ bool ReservedWord::isCharacterPossibleAfterToken(char c)
   return isOk;
 }
 
+// what can start an operand, or the closing bracket of an empty call
 bool OpenBracket::isCharacterPossibleAfterToken(char c)
 {
-  bool isOk = ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (c >= '0' && c <= '9') || isspace(c));
+  bool isOk = ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (c >= '0' && c <= '9') || isNameByte(c) || isBlank(c));
 
   switch (c)
   {
   case '+':
   case '-':
+  case '!':
+  case '~':
   case '(':
+  case '"':
+  case ')':
+  case ']':
     isOk = true;
     break;
   }
@@ -80,9 +103,10 @@ bool OpenBracket::isCharacterPossibleAfterToken(char c)
   return isOk;
 }
 
+// an operator, another bracket, or the statement that follows a condition like if (a) x
 bool CloseBracket::isCharacterPossibleAfterToken(char c)
 {
-  bool isOk = ((c >= 'A' && c <= 'Z') || c == '_' || (c >= '0' && c <= '9') || isspace(c));
+  bool isOk = ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (c >= '0' && c <= '9') || isNameByte(c) || isBlank(c));
 
   switch (c)
   {
@@ -95,6 +119,8 @@ bool CloseBracket::isCharacterPossibleAfterToken(char c)
   case '>':
   case '=': // if it's ==
   case '(':
+  case ')':
+  case '[':
   case ']':
   case '&':
   case '!':
@@ -102,6 +128,7 @@ bool CloseBracket::isCharacterPossibleAfterToken(char c)
   case '^':
   case ',':
   case ';':
+  case 0:
     isOk = true;
     break;
   }
@@ -1,14 +1,22 @@
 #pragma once
 
-#include <map>
+#include <cstdint>
+#include "Arena.h"
 
 #define _LEX_BEGIN namespace lex {
 #define _LEX_END }
 
-class SymbolTable;
-
 _LEX_BEGIN
 
+// characters owned by someone else, not null terminated
+struct StringSpan
+{
+  StringSpan() : data(nullptr), length(0) {}
+  StringSpan(const char *data, size_t length) : data(data), length(length) {}
+
+  const char *data;
+  size_t length;
+};
 
 enum TokenType
 {
@@ -44,13 +52,20 @@ enum TokenType
 
 };
 
+// tokens are made in their lexer's region and own nothing, so they go away with it;
+// delete only runs the destructor
 struct Token
 {
-  Token() : lineNumber(1) {}
+  Token() : offset(0), length(0) {}
   virtual TokenType getType() = 0;
   static bool isCharacterPossibleAfterToken(char c);
   virtual ~Token() {};
-  int lineNumber;
+  uint32_t offset;  // bytes of the source the token was made from
+  uint32_t length;
+
+  static void *operator new(size_t size, Arena &region) { return region.allocate(size, Arena::OBJECT_ALIGNMENT); }
+  static void operator delete(void *, Arena &) {}
+  static void operator delete(void *) {}
 };
 
 struct Operand : Token
@@ -106,20 +121,34 @@ struct Integer : Operand
 
 struct Float : Operand
 {
-  Float() : value(0) {}
-  Float(float v) : value(v) {}
+  enum FloatType
+  {
+    SINGLE,  // no suffix or f
+    DOUBLE   // d
+  };
+  Float() : value(0), type(SINGLE) {}
+  Float(float v) : value(v), type(SINGLE) {}
+  Float(double v) : value(v), type(DOUBLE) {}
 
   TokenType getType() { return TokenType::FLOAT; }
-  float value;
+  double value;  // exactly the float for SINGLE
+  FloatType type;
 };
 
 struct Literal : Operand
 {
-  Literal() {}
-  Literal(const char *v) : value(v) {}
+  enum LiteralType
+  {
+    PLAIN,
+    ESCAPED   // text holds escape sequences, Lexer::getLiteralValue decodes them
+  };
+
+  Literal() : type(PLAIN) {}
+  Literal(StringSpan text, LiteralType type) : text(text), type(type) {}
 
   TokenType getType() { return TokenType::LITERAL; }
-  const char *value;
+  StringSpan text;  // between the quotes, points into the source
+  LiteralType type;
 };
 
 struct Boolean : Operand
@@ -133,11 +162,11 @@ struct Boolean : Operand
 
 struct Identifier : Operand
 {
-  Identifier(size_t v, SymbolTable *symTable) : indexInSymTable(v), mySymTable(symTable) {}
+  Identifier(size_t symbol, uint32_t scope) : symbol(symbol), scope(scope) {}
 
   TokenType getType() { return TokenType::IDENTIFIER; }
-  size_t indexInSymTable;
-  SymbolTable *mySymTable;
+  size_t symbol;   // id in the lexer's ScopedSymbolTable
+  uint32_t scope;
 };
 
 struct Comparison : Operator
@@ -239,20 +268,34 @@ struct Assignment : Operator
   TokenType getType() { return TokenType::ASSIGNMENT; }
 };
 
+struct LeftRoundBracket : OpenBracket
+{
+  TokenType getType() { return TokenType::LEFT_RND_BRACKET; }
+};
+
+struct RightRoundBracket : CloseBracket
+{
+  TokenType getType() { return TokenType::RIGHT_RND_BRACKET; }
+};
 
+struct LeftSquareBracket : OpenBracket
+{
+  TokenType getType() { return TokenType::LEFT_SQR_BRACKET; }
+};
 
-struct CharToDigit
+struct RightSquareBracket : CloseBracket
 {
-public:
-  CharToDigit();
-  int getDigit(char c) const
-  {
-    if (charToDigit.find(c) == charToDigit.end()) 
-      return -1;
-    return charToDigit[c];
-  }
-private:
-  mutable std::map<char, size_t> charToDigit;
+  TokenType getType() { return TokenType::RIGHT_SQR_BRACKET; }
+};
+
+struct Semicolon : Token
+{
+  TokenType getType() { return TokenType::SEMICOLON; }
+};
+
+struct Comma : Token
+{
+  TokenType getType() { return TokenType::COMMA; }
 };
 
 
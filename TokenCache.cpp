@@ -0,0 +1,311 @@
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <atomic>
+#include "TokenCache.h"
+#include "Lexer.h"
+#include "Bits.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+_LEX_BEGIN
+
+static const uint32_t CACHE_MAGIC = 0x4B544741;  // "AGTK" read on a little-endian machine
+static const uint32_t CACHE_FORMAT_VERSION = 1;
+static const char CACHE_EXTENSION[] = ".agt";
+
+static std::atomic<unsigned> temporaryCount(0);  // tells apart entries written at once
+
+enum CacheSection
+{
+  SECTION_VALUES,
+  SECTION_OFFSETS,
+  SECTION_LENGTHS,
+  SECTION_TYPES,
+  SECTION_SUBTYPES,
+  SECTION_SYMBOLS,
+  SECTION_NAMES,
+
+  SECTION_COUNT
+};
+
+// first bytes of an entry; every section starts 8-byte aligned at an offset from here
+struct CachedTokens::Header
+{
+  uint32_t magic;
+  uint32_t formatVersion;
+  uint32_t lexerVersion;
+  uint32_t tokenCount;
+  uint64_t key;
+  uint64_t sourceLength;
+  uint64_t fileSize;
+  uint32_t symbolCount;
+  uint32_t nameBytes;
+  uint64_t sections[SECTION_COUNT];
+};
+
+struct CachedTokens::Symbol
+{
+  uint32_t nameOffset;  // into the names section
+  uint32_t nameLength;
+  uint32_t scope;
+  uint32_t type;        // DataType
+};
+
+static uint64_t alignSection(uint64_t offset)
+{
+  return (offset + 7) & ~static_cast<uint64_t>(7);
+}
+
+void TokenCache::getSectionSizes(uint64_t tokenCount, uint64_t symbolCount, uint64_t nameBytes, uint64_t *sizes)
+{
+  sizes[SECTION_VALUES] = tokenCount * sizeof(TokenValue);
+  sizes[SECTION_OFFSETS] = tokenCount * sizeof(uint32_t);
+  sizes[SECTION_LENGTHS] = tokenCount * sizeof(uint32_t);
+  sizes[SECTION_TYPES] = tokenCount;
+  sizes[SECTION_SUBTYPES] = tokenCount;
+  sizes[SECTION_SYMBOLS] = symbolCount * sizeof(CachedTokens::Symbol);
+  sizes[SECTION_NAMES] = nameBytes;
+}
+
+static void appendHex(std::string &s, uint64_t value, int digits)
+{
+  static const char hexDigits[] = "0123456789abcdef";
+  for (int shift = 4 * (digits - 1); shift >= 0; shift -= 4)
+    s += hexDigits[(value >> shift) & 0xF];
+}
+
+size_t CachedTokens::getSymbolCount() const
+{
+  return header ? header->symbolCount : 0;
+}
+
+const CachedTokens::Symbol *CachedTokens::getSymbol(uint32_t symbol) const
+{
+  const char *base = reinterpret_cast<const char *>(header);
+  return reinterpret_cast<const Symbol *>(base + header->sections[SECTION_SYMBOLS]) + symbol;
+}
+
+const char *CachedTokens::getSymbolName(uint32_t symbol) const
+{
+  const char *base = reinterpret_cast<const char *>(header);
+  return base + header->sections[SECTION_NAMES] + getSymbol(symbol)->nameOffset;
+}
+
+size_t CachedTokens::getSymbolNameLength(uint32_t symbol) const
+{
+  return getSymbol(symbol)->nameLength;
+}
+
+uint32_t CachedTokens::getSymbolScope(uint32_t symbol) const
+{
+  return getSymbol(symbol)->scope;
+}
+
+DataType CachedTokens::getSymbolType(uint32_t symbol) const
+{
+  return static_cast<DataType>(getSymbol(symbol)->type);
+}
+
+void CachedTokens::release()
+{
+  file.release();
+  header = nullptr;
+  tokens = TokenView();
+}
+
+TokenCache::TokenCache(const std::string &directory) : directory(directory)
+{
+}
+
+uint64_t TokenCache::getKey(const char *text, size_t length)
+{
+  return bits::hashBytes64(text, length, LEXER_VERSION);
+}
+
+std::string TokenCache::getPath(uint64_t key) const
+{
+  std::string path = directory;
+  if (!path.empty() && path[path.size() - 1] != '/' && path[path.size() - 1] != '\\')
+    path += '/';
+  appendHex(path, key, 16);
+  return path + CACHE_EXTENSION;
+}
+
+bool TokenCache::load(const char *text, size_t length, CachedTokens &cached) const
+{
+  cached.release();
+  uint64_t key = getKey(text, length);
+  if (!cached.file.mapFile(getPath(key).c_str()))
+    return false;
+
+  // the entry is trusted as far as the header goes: the file is the size the header says
+  // and every section lies inside it
+  const char *base = cached.file.data();
+  size_t fileSize = cached.file.size();
+  const CachedTokens::Header *header = reinterpret_cast<const CachedTokens::Header *>(base);
+  bool valid = fileSize >= sizeof(CachedTokens::Header) && header->magic == CACHE_MAGIC
+    && header->formatVersion == CACHE_FORMAT_VERSION && header->lexerVersion == LEXER_VERSION
+    && header->key == key && header->sourceLength == length && header->fileSize == fileSize;
+
+  uint64_t sizes[SECTION_COUNT];
+  if (valid)
+    getSectionSizes(header->tokenCount, header->symbolCount, header->nameBytes, sizes);
+  for (int i = 0; valid && i < SECTION_COUNT; i++)
+  {
+    uint64_t offset = header->sections[i];
+    valid = offset % 8 == 0 && offset >= sizeof(CachedTokens::Header) && offset <= fileSize && sizes[i] <= fileSize - offset;
+  }
+  if (!valid)
+  {
+    cached.release();
+    return false;
+  }
+
+  cached.header = header;
+  for (uint32_t i = 0; i < header->symbolCount; i++)
+  {
+    const CachedTokens::Symbol *symbol = cached.getSymbol(i);
+    if (symbol->nameOffset > header->nameBytes || symbol->nameLength > header->nameBytes - symbol->nameOffset)
+    {
+      cached.release();
+      return false;
+    }
+  }
+
+  TokenView &tokens = cached.tokens;
+  tokens.count = header->tokenCount;
+  tokens.source = text;
+  tokens.values = reinterpret_cast<const TokenValue *>(base + header->sections[SECTION_VALUES]);
+  tokens.offsets = reinterpret_cast<const uint32_t *>(base + header->sections[SECTION_OFFSETS]);
+  tokens.lengths = reinterpret_cast<const uint32_t *>(base + header->sections[SECTION_LENGTHS]);
+  tokens.types = reinterpret_cast<const uint8_t *>(base + header->sections[SECTION_TYPES]);
+  tokens.subtypes = reinterpret_cast<const uint8_t *>(base + header->sections[SECTION_SUBTYPES]);
+  return true;
+}
+
+// appends a section at the next 8-byte boundary and moves position past it
+static bool writeSection(FILE *f, const void *data, uint64_t size, uint64_t &position)
+{
+  static const char padding[8] = { 0 };
+  uint64_t start = alignSection(position);
+  if (start != position && fwrite(padding, 1, static_cast<size_t>(start - position), f) != start - position)
+    return false;
+  position = start + size;
+  return size == 0 || fwrite(data, 1, static_cast<size_t>(size), f) == size;
+}
+
+static bool makeDirectory(const std::string &path)
+{
+#ifdef _WIN32
+  return _mkdir(path.c_str()) == 0;
+#else
+  return mkdir(path.c_str(), 0777) == 0;
+#endif
+}
+
+// replaces an entry another writer may have put there meanwhile, it has the same contents
+static bool replaceFile(const std::string &from, const std::string &to)
+{
+#ifdef _WIN32
+  return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+bool TokenCache::store(const char *text, size_t length, const TokenStream &stream, const ScopedSymbolTable &symbols) const
+{
+  TokenView tokens = stream.view();
+
+  // names shadowed in inner scopes are written once
+  std::vector<CachedTokens::Symbol> symbolData(symbols.size());
+  std::string names;
+  std::map<uint32_t, uint32_t> nameOffsets;
+  for (uint32_t i = 0; i < symbols.size(); i++)
+  {
+    const SymbolData &data = symbols.get(i);
+    std::map<uint32_t, uint32_t>::iterator known = nameOffsets.find(data.nameId);
+    if (known == nameOffsets.end())
+    {
+      known = nameOffsets.insert(std::make_pair(data.nameId, static_cast<uint32_t>(names.size()))).first;
+      names.append(symbols.getName(i), symbols.getNameLength(i));
+    }
+
+    CachedTokens::Symbol &symbol = symbolData[i];
+    symbol.nameOffset = known->second;
+    symbol.nameLength = static_cast<uint32_t>(symbols.getNameLength(i));
+    symbol.scope = symbols.getScope(i);
+    symbol.type = data.type;
+  }
+
+  CachedTokens::Header header;
+  memset(&header, 0, sizeof(header));
+  header.magic = CACHE_MAGIC;
+  header.formatVersion = CACHE_FORMAT_VERSION;
+  header.lexerVersion = LEXER_VERSION;
+  header.tokenCount = static_cast<uint32_t>(tokens.size());
+  header.key = getKey(text, length);
+  header.sourceLength = length;
+  header.symbolCount = static_cast<uint32_t>(symbolData.size());
+  header.nameBytes = static_cast<uint32_t>(names.size());
+
+  const void *data[SECTION_COUNT];
+  data[SECTION_VALUES] = tokens.values;
+  data[SECTION_OFFSETS] = tokens.offsets;
+  data[SECTION_LENGTHS] = tokens.lengths;
+  data[SECTION_TYPES] = tokens.types;
+  data[SECTION_SUBTYPES] = tokens.subtypes;
+  data[SECTION_SYMBOLS] = symbolData.empty() ? nullptr : &symbolData[0];
+  data[SECTION_NAMES] = names.data();
+
+  uint64_t sizes[SECTION_COUNT];
+  getSectionSizes(header.tokenCount, header.symbolCount, header.nameBytes, sizes);
+  uint64_t position = sizeof(header);
+  for (int i = 0; i < SECTION_COUNT; i++)
+  {
+    header.sections[i] = alignSection(position);
+    position = header.sections[i] + sizes[i];
+  }
+  header.fileSize = position;
+
+  std::string path = getPath(header.key);
+  std::string temporary = path + ".tmp";
+#ifdef _WIN32
+  appendHex(temporary, _getpid(), 8);
+#else
+  appendHex(temporary, getpid(), 8);
+#endif
+  appendHex(temporary, temporaryCount++, 8);
+
+  FILE *f = fopen(temporary.c_str(), "wb");
+  if (f == nullptr && makeDirectory(directory))
+    f = fopen(temporary.c_str(), "wb");
+  if (f == nullptr)
+    return false;
+
+  position = 0;
+  bool written = writeSection(f, &header, sizeof(header), position);
+  for (int i = 0; written && i < SECTION_COUNT; i++)
+    written = writeSection(f, data[i], sizes[i], position);
+  written = (fclose(f) == 0) && written;
+
+  if (!written || !replaceFile(temporary, path))
+  {
+    remove(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+_LEX_END
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "TokenStream.h"
+#include "SourceBuffer.h"
+#include "SymbolTable.h"
+
+_LEX_BEGIN
+
+class TokenCache;
+
+// tokens and symbols of one source text as found in the cache. The arrays of the view and
+// the symbol names point straight into the mapped cache file, nothing is copied per token
+class CachedTokens
+{
+public:
+  CachedTokens() : header(nullptr) {}
+
+  // offsets of the tokens refer to the text the entry was looked up with
+  TokenView view() const { return tokens; }
+
+  size_t getSymbolCount() const;
+  const char *getSymbolName(uint32_t symbol) const;  // not null terminated
+  size_t getSymbolNameLength(uint32_t symbol) const;
+  uint32_t getSymbolScope(uint32_t symbol) const;
+  DataType getSymbolType(uint32_t symbol) const;
+
+  void release();
+
+private:
+  friend class TokenCache;
+
+  struct Header;
+  struct Symbol;
+
+  CachedTokens(const CachedTokens &);
+  CachedTokens &operator=(const CachedTokens &);
+
+  const Symbol *getSymbol(uint32_t symbol) const;
+
+  SourceBuffer file;
+  const Header *header;
+  TokenView tokens;
+};
+
+// directory of lexed files named after a hash of their text and the lexer version. An entry
+// holds the token arrays and the symbols as they are laid out in memory, addressed by offsets
+// from the start of the file, so a hit is a mapping and a few checks of the header. Entries are
+// written under a temporary name and renamed, a reader never sees half of one
+class TokenCache
+{
+public:
+  explicit TokenCache(const std::string &directory);
+
+  // false on a miss, or if the entry found is damaged or was made by another lexer
+  bool load(const char *text, size_t length, CachedTokens &cached) const;
+  // stream and symbols must be what the lexer made of text without an error; false if the
+  // entry can't be written, which only costs the next run a miss
+  bool store(const char *text, size_t length, const TokenStream &stream, const ScopedSymbolTable &symbols) const;
+
+  static uint64_t getKey(const char *text, size_t length);
+
+private:
+  std::string directory;
+
+  std::string getPath(uint64_t key) const;
+  static void getSectionSizes(uint64_t tokenCount, uint64_t symbolCount, uint64_t nameBytes, uint64_t *sizes);
+};
+
+_LEX_END
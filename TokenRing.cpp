@@ -0,0 +1,98 @@
+#include <thread>
+#include "TokenRing.h"
+
+_LEX_BEGIN
+
+// a short spin covers the other side being busy for a moment, after that the core is handed
+// over, which is also what lets the other side run at all when both share one core
+static void backOff(unsigned &spins)
+{
+  if (++spins > 64)
+    std::this_thread::yield();
+}
+
+TokenRing::TokenRing(size_t capacity) : producerSeenHead(0), consumerSeenTail(0)
+{
+  size_t size = 1;
+  while (size < capacity)
+    size <<= 1;
+  slots.resize(size);
+  mask = size - 1;
+
+  tail.store(0, std::memory_order_relaxed);
+  head.store(0, std::memory_order_relaxed);
+  closed.store(false, std::memory_order_relaxed);
+  stopped.store(false, std::memory_order_relaxed);
+}
+
+size_t TokenRing::reserve(Lexeme *&out, size_t maxCount)
+{
+  size_t position = tail.load(std::memory_order_relaxed);
+  unsigned spins = 0;
+  while (position - producerSeenHead > mask)
+  {
+    if (stopped.load(std::memory_order_acquire))
+      return 0;
+    backOff(spins);
+    producerSeenHead = head.load(std::memory_order_acquire);
+  }
+  if (stopped.load(std::memory_order_relaxed))
+    return 0;
+
+  size_t index = position & mask;
+  size_t count = capacity() - (position - producerSeenHead);
+  if (count > capacity() - index) // up to the end of the array, the rest comes next time
+    count = capacity() - index;
+  if (count > maxCount)
+    count = maxCount;
+
+  out = &slots[index];
+  return count;
+}
+
+void TokenRing::commit(size_t count)
+{
+  tail.store(tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+}
+
+void TokenRing::close()
+{
+  closed.store(true, std::memory_order_release);
+}
+
+size_t TokenRing::peek(const Lexeme *&out)
+{
+  size_t position = head.load(std::memory_order_relaxed);
+  unsigned spins = 0;
+  while (position == consumerSeenTail)
+  {
+    // closed is read before tail, so a close seen here comes after every commit
+    bool done = closed.load(std::memory_order_acquire);
+    consumerSeenTail = tail.load(std::memory_order_acquire);
+    if (position != consumerSeenTail)
+      break;
+    if (done)
+      return 0;
+    backOff(spins);
+  }
+
+  size_t index = position & mask;
+  size_t count = consumerSeenTail - position;
+  if (count > capacity() - index)
+    count = capacity() - index;
+
+  out = &slots[index];
+  return count;
+}
+
+void TokenRing::release(size_t count)
+{
+  head.store(head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+}
+
+void TokenRing::stop()
+{
+  stopped.store(true, std::memory_order_release);
+}
+
+_LEX_END
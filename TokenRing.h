@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include "Scanner.h"
+
+_LEX_BEGIN
+
+const size_t CACHE_LINE_SIZE = 64;
+
+// bounded queue of lexemes from one producer thread to one consumer thread, without locks.
+// Each side works on contiguous runs of slots in place: the producer reserves free slots,
+// fills them and commits them, the consumer peeks at filled slots and releases them. A
+// side that finds the ring full or empty waits, so a fast lexer can't run ahead of its
+// consumer by more than the capacity
+class TokenRing
+{
+public:
+  explicit TokenRing(size_t capacity = 16384); // rounded up to a power of two
+
+  // producer: points slots at up to maxCount free slots and returns how many, 0 once the
+  // consumer has stopped
+  size_t reserve(Lexeme *&slots, size_t maxCount);
+  void commit(size_t count);
+  void close(); // no more lexemes will be committed
+
+  // consumer: points slots at the filled slots and returns how many, 0 once the ring is
+  // closed and empty
+  size_t peek(const Lexeme *&slots);
+  void release(size_t count);
+  void stop(); // no more lexemes will be read, a waiting producer gives up
+
+  size_t capacity() const { return mask + 1; }
+
+private:
+  TokenRing(const TokenRing &);
+  TokenRing &operator=(const TokenRing &);
+
+  // read only once made
+  std::vector<Lexeme> slots;
+  size_t mask;
+  char pad0[CACHE_LINE_SIZE];
+
+  // positions only grow, a slot is at position & mask; each side keeps the last position
+  // of the other it saw, so it touches the other's line only when that one runs out
+  std::atomic<size_t> tail;     // next position the producer fills
+  size_t producerSeenHead;
+  char pad1[CACHE_LINE_SIZE];
+
+  std::atomic<size_t> head;     // next position the consumer reads
+  size_t consumerSeenTail;
+  char pad2[CACHE_LINE_SIZE];
+
+  std::atomic<bool> closed;
+  std::atomic<bool> stopped;
+};
+
+_LEX_END
@@ -0,0 +1,101 @@
+#include "TokenStream.h"
+
+_LEX_BEGIN
+
+void TokenStream::push(const Lexeme &lexeme)
+{
+  types.push_back(static_cast<uint8_t>(lexeme.type));
+  subtypes.push_back(static_cast<uint8_t>(lexeme.subtype));
+  offsets.push_back(lexeme.offset);
+  lengths.push_back(lexeme.length);
+  values.push_back(makeValue(lexeme));
+}
+
+TokenValue TokenStream::makeValue(const Lexeme &lexeme)
+{
+  TokenValue value;
+  value.symbol.index = 0;
+  value.symbol.scope = 0;
+
+  switch (lexeme.type)
+  {
+  case INTEGER:
+    value.intValue = lexeme.intValue;
+    break;
+  case FLOAT:
+    if (lexeme.subtype == Float::DOUBLE)
+      value.doubleValue = lexeme.doubleValue;
+    else
+      value.floatValue = lexeme.floatValue;
+    break;
+  case BOOL:
+    value.boolValue = lexeme.boolValue;
+    break;
+  case IDENTIFIER:
+    value.symbol.index = static_cast<uint32_t>(lexeme.symbolIndex);
+    value.symbol.scope = lexeme.scope;
+    break;
+  default: // no value, the symbol fields set above read as zero
+    break;
+  }
+  return value;
+}
+
+void TokenStream::reserve(size_t n)
+{
+  types.reserve(n);
+  subtypes.reserve(n);
+  offsets.reserve(n);
+  lengths.reserve(n);
+  values.reserve(n);
+}
+
+void TokenStream::resize(size_t n)
+{
+  types.resize(n);
+  subtypes.resize(n);
+  offsets.resize(n);
+  lengths.resize(n);
+  values.resize(n);
+}
+
+void TokenStream::write(size_t index, const Lexeme *lexemes, size_t count)
+{
+  for (size_t i = 0; i < count; i++, index++)
+  {
+    const Lexeme &lexeme = lexemes[i];
+
+    types[index] = static_cast<uint8_t>(lexeme.type);
+    subtypes[index] = static_cast<uint8_t>(lexeme.subtype);
+    offsets[index] = lexeme.offset;
+    lengths[index] = lexeme.length;
+    values[index] = makeValue(lexeme);
+  }
+}
+
+void TokenStream::clear()
+{
+  types.clear();
+  subtypes.clear();
+  offsets.clear();
+  lengths.clear();
+  values.clear();
+}
+
+TokenView TokenStream::view() const
+{
+  TokenView v;
+  v.count = types.size();
+  v.source = source;
+  if (v.count == 0)
+    return v;
+
+  v.types = &types[0];
+  v.subtypes = &subtypes[0];
+  v.offsets = &offsets[0];
+  v.lengths = &lengths[0];
+  v.values = &values[0];
+  return v;
+}
+
+_LEX_END
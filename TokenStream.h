@@ -0,0 +1,133 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "Scanner.h"
+
+_LEX_BEGIN
+
+// inline payload of a token, which member is valid depends on the token type
+union TokenValue
+{
+  int intValue;
+  float floatValue;
+  double doubleValue;
+  bool boolValue;
+  struct
+  {
+    uint32_t index;
+    uint32_t scope;
+  } symbol;
+};
+
+class TokenView;
+
+// one token of a stream, read straight out of the arrays
+class TokenRef
+{
+public:
+  TokenRef(const TokenView *view, size_t index) : view(view), index(index) {}
+
+  TokenType getType() const;
+  int getSubtype() const;
+  size_t getOffset() const;
+  size_t getLength() const;
+  const char *getText() const;  // points into the source, not null terminated
+
+  int getInt() const;
+  float getFloat() const;
+  double getDouble() const;  // either float subtype, widened if single
+  bool getBool() const;
+  size_t getSymbolIndex() const;
+  uint32_t getScope() const;
+
+private:
+  const TokenView *view;
+  size_t index;
+};
+
+// non-owning window over struct-of-arrays token storage
+class TokenView
+{
+public:
+  class const_iterator
+  {
+  public:
+    const_iterator(const TokenView *view, size_t index) : view(view), index(index) {}
+
+    TokenRef operator*() const { return TokenRef(view, index); }
+    const_iterator &operator++() { index++; return *this; }
+    const_iterator operator++(int) { const_iterator old = *this; index++; return old; }
+    bool operator==(const const_iterator &other) const { return index == other.index; }
+    bool operator!=(const const_iterator &other) const { return index != other.index; }
+
+  private:
+    const TokenView *view;
+    size_t index;
+  };
+
+  TokenView() : count(0), source(nullptr), types(nullptr), subtypes(nullptr),
+    offsets(nullptr), lengths(nullptr), values(nullptr) {}
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  TokenRef operator[](size_t i) const { return TokenRef(this, i); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, count); }
+
+  size_t count;
+  const char *source;
+  const uint8_t *types;
+  const uint8_t *subtypes;
+  const uint32_t *offsets;
+  const uint32_t *lengths;
+  const TokenValue *values;
+};
+
+// growable token storage, one contiguous array per field
+class TokenStream
+{
+public:
+  TokenStream() : source(nullptr) {}
+
+  void push(const Lexeme &lexeme);
+  void reserve(size_t n);
+  void clear();
+
+  // filling from several threads: the stream is resized once and disjoint ranges are
+  // written concurrently
+  void resize(size_t n);
+  void write(size_t index, const Lexeme *lexemes, size_t count);
+
+  size_t size() const { return types.size(); }
+  void setSource(const char *text) { source = text; }
+  TokenView view() const;
+
+private:
+  const char *source;
+  std::vector<uint8_t> types;
+  std::vector<uint8_t> subtypes;
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> lengths;
+  std::vector<TokenValue> values;
+
+  static TokenValue makeValue(const Lexeme &lexeme);
+};
+
+inline TokenType TokenRef::getType() const { return static_cast<TokenType>(view->types[index]); }
+inline int TokenRef::getSubtype() const { return view->subtypes[index]; }
+inline size_t TokenRef::getOffset() const { return view->offsets[index]; }
+inline size_t TokenRef::getLength() const { return view->lengths[index]; }
+inline const char *TokenRef::getText() const { return view->source + view->offsets[index]; }
+inline int TokenRef::getInt() const { return view->values[index].intValue; }
+inline float TokenRef::getFloat() const { return static_cast<float>(getDouble()); }
+inline double TokenRef::getDouble() const
+{
+  const TokenValue &value = view->values[index];
+  return view->subtypes[index] == Float::DOUBLE ? value.doubleValue : value.floatValue;
+}
+inline bool TokenRef::getBool() const { return view->values[index].boolValue; }
+inline size_t TokenRef::getSymbolIndex() const { return view->values[index].symbol.index; }
+inline uint32_t TokenRef::getScope() const { return view->values[index].symbol.scope; }
+
+_LEX_END
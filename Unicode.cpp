@@ -0,0 +1,94 @@
+#include "Unicode.h"
+
+_LEX_BEGIN
+
+static inline bool isContinuation(unsigned char c)
+{
+  return (c & 0xC0) == 0x80;
+}
+
+size_t decodeUtf8(const char *p, const char *end, uint32_t &codePoint)
+{
+  const unsigned char *u = reinterpret_cast<const unsigned char *>(p);
+  size_t available = end - p;
+  if (available == 0)
+    return 0;
+
+  unsigned char lead = u[0];
+  if (lead < 0x80)
+  {
+    codePoint = lead;
+    return 1;
+  }
+
+  // the smallest code point of each length keeps overlong forms out
+  size_t length;
+  uint32_t smallest;
+  if (lead >= 0xC2 && lead <= 0xDF)
+  {
+    length = 2;
+    smallest = 0x80;
+    codePoint = lead & 0x1F;
+  }
+  else if (lead >= 0xE0 && lead <= 0xEF)
+  {
+    length = 3;
+    smallest = 0x800;
+    codePoint = lead & 0x0F;
+  }
+  else if (lead >= 0xF0 && lead <= 0xF4)
+  {
+    length = 4;
+    smallest = 0x10000;
+    codePoint = lead & 0x07;
+  }
+  else
+    return 0;
+
+  if (available < length)
+    return 0;
+  for (size_t i = 1; i < length; i++)
+  {
+    if (!isContinuation(u[i]))
+      return 0;
+    codePoint = (codePoint << 6) | (u[i] & 0x3F);
+  }
+
+  if (codePoint < smallest || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+    return 0;
+  return length;
+}
+
+static bool isInRanges(uint32_t codePoint, const uint32_t (*ranges)[2], size_t count)
+{
+  size_t low = 0;
+  size_t high = count;
+  while (low < high)
+  {
+    size_t middle = (low + high) / 2;
+    if (codePoint < ranges[middle][0])
+      high = middle;
+    else if (codePoint > ranges[middle][1])
+      low = middle + 1;
+    else
+      return true;
+  }
+  return false;
+}
+
+bool isXidStart(uint32_t codePoint)
+{
+  if (codePoint < 0x80)
+    return (codePoint >= 'a' && codePoint <= 'z') || (codePoint >= 'A' && codePoint <= 'Z');
+  return isInRanges(codePoint, xidStartRanges, XID_START_RANGE_COUNT);
+}
+
+bool isXidContinue(uint32_t codePoint)
+{
+  if (codePoint < 0x80)
+    return (codePoint >= 'a' && codePoint <= 'z') || (codePoint >= 'A' && codePoint <= 'Z')
+      || (codePoint >= '0' && codePoint <= '9') || codePoint == '_';
+  return isInRanges(codePoint, xidContinueRanges, XID_CONTINUE_RANGE_COUNT);
+}
+
+_LEX_END
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include "Token.h"
+
+_LEX_BEGIN
+
+// decodes the sequence starting at p, reading no further than end, and returns its length;
+// 0 if it isn't well-formed UTF-8: a stray continuation byte, a sequence cut short, an
+// overlong form, a surrogate or a code point above U+10FFFF
+size_t decodeUtf8(const char *p, const char *end, uint32_t &codePoint);
+
+// the identifier properties of Unicode, which leave out _ and the ASCII digits at the start
+bool isXidStart(uint32_t codePoint);
+bool isXidContinue(uint32_t codePoint);
+
+const size_t XID_START_RANGE_COUNT = 653;
+const size_t XID_CONTINUE_RANGE_COUNT = 759;
+
+// first and last code point of every run above ASCII that has the property, ascending
+extern const uint32_t xidStartRanges[XID_START_RANGE_COUNT][2];
+extern const uint32_t xidContinueRanges[XID_CONTINUE_RANGE_COUNT][2];
+
+_LEX_END
@@ -0,0 +1,327 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include "Lexer.h"
+#include "Parser.h"
+#include "Corpus.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace lex;
+using namespace std;
+
+// every allocation of the process goes through here, from the pipeline's producer too
+static atomic<size_t> allocationCount(0);
+
+static void *allocate(size_t size)
+{
+  allocationCount++;
+  void *p = malloc(size ? size : 1);
+  if (p == nullptr)
+    throw bad_alloc();
+  return p;
+}
+
+void *operator new(size_t size)
+{
+  return allocate(size);
+}
+
+void operator delete(void *p)
+{
+  free(p);
+}
+
+// the sized and array forms forward to the pair above, so the library's versions are never
+// paired with these
+void operator delete(void *p, size_t)
+{
+  operator delete(p);
+}
+
+void *operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete[](void *p)
+{
+  operator delete(p);
+}
+
+void operator delete[](void *p, size_t)
+{
+  operator delete(p);
+}
+
+static size_t getPeakResidentBytes()
+{
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return 0;
+  return counters.PeakWorkingSetSize;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage))
+    return 0;
+#ifdef __APPLE__
+  return usage.ru_maxrss;
+#else
+  return usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+// which way the tokens are taken out of the lexer
+enum TokenApi
+{
+  SINGLE_TOKENS,  // Lexer::getNextToken
+  TOKEN_BATCHES,  // Lexer::getNextTokens
+  TOKEN_STREAM,   // Lexer::tokenize
+  PARSED_STREAM,  // Lexer::tokenize, then Parser::parse
+  PIPELINE        // Lexer::tokenize into a TokenRing on a second thread, Parser::parse from it
+};
+
+const size_t TOKEN_BATCH_SIZE = 256;
+
+struct RunResult
+{
+  double seconds;
+  size_t tokens;
+  size_t allocations;
+  bool finished;
+};
+
+// counts the tokens the lexer gives out through api
+static size_t drain(Lexer &lexer, TokenApi api)
+{
+  if (api == TOKEN_STREAM || api == PARSED_STREAM)
+  {
+    TokenStream tokens;
+    lexer.tokenize(tokens);
+    if (api == PARSED_STREAM)
+    {
+      Syntax tree;
+      TokenView view = tokens.view();
+      Parser(view).parse(tree);
+    }
+    return tokens.size();
+  }
+
+  if (api == PIPELINE)
+  {
+    TokenRing ring;
+    TokenStream tokens;
+    tokens.setSource(lexer.getText());
+    thread producer([&]() { lexer.tokenize(ring); });
+    Syntax tree;
+    Parser(ring, tokens).parse(tree);
+    producer.join();
+    return tokens.size();
+  }
+
+  size_t total = 0;
+  if (api == TOKEN_BATCHES)
+  {
+    Lexeme tokens[TOKEN_BATCH_SIZE];
+    size_t count;
+    BatchStatus status;
+    do
+    {
+      status = lexer.getNextTokens(tokens, TOKEN_BATCH_SIZE, count);
+      total += count;
+    } while (status == BATCH_OK);
+  }
+  else
+  {
+    while (lexer.getNextToken() != nullptr)
+      total++;
+  }
+  return total;
+}
+
+// text must be followed by \0, the lexer reads it in place; the region the lexer makes its
+// tokens in is reset afterwards, as a service would between units
+static RunResult lexOnce(const string &text, Lexer &lexer, TokenApi api, Arena &region)
+{
+  RunResult result;
+  size_t allocationsBefore = allocationCount;
+  chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+
+  lexer.setText(text.c_str(), text.size());
+  result.tokens = drain(lexer, api);
+  result.finished = lexer.getState() == FINISHED;
+  region.reset();
+
+  result.seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+  result.allocations = allocationCount - allocationsBefore;
+  return result;
+}
+
+// best of repeat runs, the others only warm up caches
+static void benchmark(const char *name, const string &text, int repeat, LexerEngine engine, TokenApi api)
+{
+  // one lexer for every run, like a worker of a service keeps one
+  Arena region;
+  Lexer lexer(&region);
+  lexer.setEngine(engine);
+  RunResult best = lexOnce(text, lexer, api, region);
+  for (int i = 1; i < repeat; i++)
+  {
+    RunResult r = lexOnce(text, lexer, api, region);
+    if (r.seconds < best.seconds)
+      best = r;
+  }
+
+  double mb = text.size() / (1024.0 * 1024.0);
+  printf("%-12s %8.2f %10.1f %10.2f %12.3f %10.1f%s\n", name, mb, mb / best.seconds, best.tokens / best.seconds / 1e6,
+    best.tokens ? static_cast<double>(best.allocations) / best.tokens : 0.0,
+    getPeakResidentBytes() / (1024.0 * 1024.0), best.finished ? "" : "  (stopped on an error)");
+}
+
+static bool readText(const char *fileName, string &text)
+{
+  ifstream file(fileName, ios::binary);
+  if (!file)
+    return false;
+  ostringstream contents;
+  contents << file.rdbuf();
+  text = contents.str();
+  return true;
+}
+
+static void usage()
+{
+  printf("usage: benchmark [options] [file.ag ...]\n"
+    "  --mix <name>     generate only this mix: identifiers, numbers, strings, comments, nesting or blend\n"
+    "  --size <MB>      size of each generated corpus, 16 by default\n"
+    "  --seed <n>       seed of the corpus generator\n"
+    "  --repeat <n>     runs per input, the fastest is reported; 5 by default\n"
+    "  --cascade        time the matcher cascade instead of the automaton\n"
+    "  --batch          time Lexer::getNextTokens instead of Lexer::getNextToken\n"
+    "  --stream         time Lexer::tokenize instead of Lexer::getNextToken\n"
+    "  --parse          time Lexer::tokenize followed by parsing the stream\n"
+    "  --pipeline       time lexing on a second thread while parsing what it has lexed\n"
+    "  --write          save the generated corpora as <mix>.ag instead of timing them\n"
+    "Files given on the command line are timed instead of generated corpora.\n");
+}
+
+int main(int argc, char *argv[])
+{
+  vector<CorpusMix> mixes;
+  vector<const char *> files;
+  double sizeMB = 16;
+  uint32_t seed = 1;
+  int repeat = 5;
+  LexerEngine engine = TABLE_DRIVEN;
+  TokenApi api = SINGLE_TOKENS;
+  bool write = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--mix") && hasValue)
+    {
+      CorpusMix mix;
+      if (!findMix(argv[++i], mix))
+      {
+        usage();
+        return 1;
+      }
+      mixes.push_back(mix);
+    }
+    else if (!strcmp(argv[i], "--size") && hasValue)
+      sizeMB = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--seed") && hasValue)
+      seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    else if (!strcmp(argv[i], "--repeat") && hasValue)
+      repeat = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--cascade"))
+      engine = MATCHER_CASCADE;
+    else if (!strcmp(argv[i], "--batch"))
+      api = TOKEN_BATCHES;
+    else if (!strcmp(argv[i], "--stream"))
+      api = TOKEN_STREAM;
+    else if (!strcmp(argv[i], "--parse"))
+      api = PARSED_STREAM;
+    else if (!strcmp(argv[i], "--pipeline"))
+      api = PIPELINE;
+    else if (!strcmp(argv[i], "--write"))
+      write = true;
+    else if (argv[i][0] == '-')
+    {
+      usage();
+      return 1;
+    }
+    else
+      files.push_back(argv[i]);
+  }
+
+  if (repeat < 1 || sizeMB <= 0)
+  {
+    usage();
+    return 1;
+  }
+
+  if (mixes.empty())
+  {
+    for (int i = 0; i < CORPUS_MIX_COUNT; i++)
+      mixes.push_back(static_cast<CorpusMix>(i));
+  }
+
+  if (!write)
+    printf("%-12s %8s %10s %10s %12s %10s\n", "input", "MB", "MB/s", "Mtokens/s", "allocs/token", "peak RSS MB");
+
+  if (!files.empty())
+  {
+    for (size_t i = 0; i < files.size(); i++)
+    {
+      string text;
+      if (!readText(files[i], text))
+      {
+        fprintf(stderr, "can't read %s\n", files[i]);
+        return 1;
+      }
+      benchmark(files[i], text, repeat, engine, api);
+    }
+    return 0;
+  }
+
+  size_t size = static_cast<size_t>(sizeMB * 1024 * 1024);
+  for (size_t i = 0; i < mixes.size(); i++)
+  {
+    string text = generateCorpus(mixes[i], size, seed);
+    if (write)
+    {
+      string fileName = string(getMixName(mixes[i])) + ".ag";
+      ofstream file(fileName.c_str(), ios::binary);
+      file.write(text.data(), text.size());
+      if (!file)
+      {
+        fprintf(stderr, "can't write %s\n", fileName.c_str());
+        return 1;
+      }
+      continue;
+    }
+    benchmark(getMixName(mixes[i]), text, repeat, engine, api);
+  }
+
+  return 0;
+}
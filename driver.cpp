@@ -1,23 +1,427 @@
 #include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
 #include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <chrono>
 #include "Lexer.h"
+#include "ParallelLexer.h"
+#include "Parser.h"
+#include "ConstantFolder.h"
+#include "SourceFiles.h"
+#include "TokenCache.h"
 
 using namespace lex;
 using namespace std;
 
-int main()
+static const size_t TOKEN_BATCH_SIZE = 256; // a few KB of lexemes, small enough for L1
+
+static const char *describeLexerState(LexerState state)
+{
+  switch (state)
+  {
+  case WRONG_FILE:
+    return "can't be read";
+  case CONSTANT_OVERFLOW:
+    return "lexing stopped on a constant that doesn't fit";
+  case WRONG_ENCODING:
+    return "isn't valid UTF-8";
+  default:
+    return "lexing stopped on an error";
+  }
+}
+
+static string describeLocation(LineIndex &lines, size_t offset)
+{
+  SourceLocation location = lines.locate(offset);
+  ostringstream text;
+  text << "line " << location.line << ", column " << location.column;
+  return text.str();
+}
+
+// a file that can't be read has no place to point at, other errors are put where lexing stopped
+static string describeLexerError(LexerState state, size_t offset, LineIndex &lines)
+{
+  string message = describeLexerState(state);
+  if (state != WRONG_FILE)
+    message += " at " + describeLocation(lines, offset);
+  return message;
+}
+
+static string describeLexerError(Lexer &lexer)
+{
+  return describeLexerError(lexer.getState(), lexer.getOffset(), lexer.getLineIndex());
+}
+
+static string describeParseError(const Parser &parser, const TokenView &tokens, LineIndex &lines)
+{
+  string message = parser.getError();
+  size_t at = parser.getErrorToken();
+  if (at < tokens.size())
+    return message + " at " + describeLocation(lines, tokens[at].getOffset());
+  if (tokens.empty())
+    return message + " at the end";
+
+  TokenRef last = tokens[tokens.size() - 1];
+  return message + " at the end, after " + describeLocation(lines, last.getOffset() + last.getLength());
+}
+
+static bool checkLexer(const char *fileName, Lexer &lexer, const LexerStats *stats)
+{
+  if (stats)
+    stats->print(cout);
+
+  if (lexer.getState() != FINISHED)
+  {
+    cerr << fileName << ": " << describeLexerError(lexer) << endl;
+    return false;
+  }
+  return true;
+}
+
+static bool checkParser(const char *fileName, const Parser &parser, bool parsed, const TokenView &tokens, LineIndex &lines)
+{
+  if (parsed)
+    return true;
+
+  cerr << fileName << ": " << describeParseError(parser, tokens, lines) << endl;
+  return false;
+}
+
+// folds the constant expressions of a parsed tree, sets error if one divides by zero
+static bool foldTree(Syntax &tree, const TokenView &tokens, LineIndex &lines, string &error)
+{
+  ConstantFolder folder(tokens);
+  if (folder.fold(tree))
+    return true;
+
+  error = string(folder.getError()) + " at " + describeLocation(lines, tokens[folder.getErrorToken()].getOffset());
+  return false;
+}
+
+static bool checkFolder(const char *fileName, Syntax &tree, const TokenView &tokens, LineIndex &lines)
+{
+  string error;
+  if (foldTree(tree, tokens, lines, error))
+    return true;
+
+  cerr << fileName << ": " << error << endl;
+  return false;
+}
+
+// what one worker of a batch keeps from file to file, so the lexer's tables and the token
+// and tree storage are only grown, never made again
+struct BatchWorker
+{
+  BatchWorker() : bytes(0), tokens(0), cachedFiles(0) {}
+
+  Lexer lexer;
+  TokenStream stream;
+  Syntax tree;
+  LexerStats stats;
+  SourceBuffer source;   // the file being looked up in the cache
+  CachedTokens cached;
+  LineIndex lines;       // of the text the tokens point into
+  size_t bytes;
+  size_t tokens;
+  size_t cachedFiles;
+};
+
+// the tokens of the file, taken from the cache when it has them and stored there when it
+// doesn't; sets error if the file can't be read or lexed
+static bool lexFile(BatchWorker &worker, const string &fileName, const TokenCache *cache, TokenView &tokens, string &error)
+{
+  Lexer &lexer = worker.lexer;
+  if (cache == nullptr)
+  {
+    if (!lexer.readFile(fileName.c_str()))
+    {
+      error = describeLexerError(lexer);
+      return false;
+    }
+  }
+  else
+  {
+    if (!worker.source.mapFile(fileName.c_str()))
+    {
+      error = describeLexerState(WRONG_FILE);
+      return false;
+    }
+    if (cache->load(worker.source.data(), worker.source.size(), worker.cached))
+    {
+      tokens = worker.cached.view();
+      worker.lines.reset(worker.source.data(), worker.source.size());
+      worker.bytes += worker.source.size();
+      worker.tokens += tokens.size();
+      worker.cachedFiles++;
+      return true;
+    }
+    lexer.setText(worker.source.data(), worker.source.size());
+  }
+
+  worker.stream.clear();
+  bool lexed = lexer.tokenize(worker.stream);
+  worker.bytes += lexer.getTextLength();
+  worker.tokens += worker.stream.size();
+  if (!lexed)
+  {
+    error = describeLexerError(lexer);
+    return false;
+  }
+
+  if (cache)
+    cache->store(lexer.getText(), lexer.getTextLength(), worker.stream, lexer.getSymbols());
+  tokens = worker.stream.view();
+  worker.lines.reset(lexer.getText(), lexer.getTextLength());
+  return true;
+}
+
+// leaves error empty if the file lexes, and parses and folds when asked to
+static void processFile(BatchWorker &worker, const string &fileName, bool parse, bool fold, const TokenCache *cache, string &error)
+{
+  TokenView tokens;
+  if (!lexFile(worker, fileName, cache, tokens, error))
+    return;
+
+  if (parse)
+  {
+    Parser parser(tokens);
+    if (!parser.parse(worker.tree))
+      error = describeParseError(parser, tokens, worker.lines);
+    else if (fold)
+      foldTree(worker.tree, tokens, worker.lines, error);
+  }
+}
+
+// every file is a job of its own on a work-stealing pool; errors are reported in the order
+// of the files, then totals for the whole batch
+static int runBatch(const vector<string> &files, bool parse, bool fold, bool printStats, size_t threadCount, const TokenCache *cache)
 {
-  Lexer lexer("input.ag");
-  
-  vector<Token*> tokens;
-  Token * token = nullptr;
+  chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
 
-  token = lexer.getNextToken();
-  while (token != nullptr)
+  ThreadPool pool(threadCount);
+  vector<BatchWorker *> workers;
+  for (size_t i = 0; i < pool.size(); i++)
   {
-    tokens.push_back(token);
-    token = lexer.getNextToken();
+    workers.push_back(new BatchWorker);
+    if (printStats)
+      workers[i]->lexer.setStats(&workers[i]->stats);
   }
 
+  vector<string> errors(files.size());
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    const string *fileName = &files[i];
+    string *error = &errors[i];
+    pool.submitIndexed([&workers, fileName, error, parse, fold, cache](size_t worker) {
+      processFile(*workers[worker], *fileName, parse, fold, cache, *error);
+    });
+  }
+  pool.wait();
+
+  double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+  size_t failed = 0;
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    if (!errors[i].empty())
+    {
+      cerr << files[i] << ": " << errors[i] << endl;
+      failed++;
+    }
+  }
+
+  LexerStats stats;
+  size_t bytes = 0;
+  size_t tokens = 0;
+  size_t cachedFiles = 0;
+  for (size_t i = 0; i < workers.size(); i++)
+  {
+    stats.add(workers[i]->stats);
+    bytes += workers[i]->bytes;
+    tokens += workers[i]->tokens;
+    cachedFiles += workers[i]->cachedFiles;
+    delete workers[i];
+  }
+
+  if (printStats)
+    stats.print(cout);
+
+  double mb = bytes / (1024.0 * 1024.0);
+  cout << files.size() << " files, " << failed << " failed, ";
+  if (cache)
+    cout << cachedFiles << " from cache, ";
+  cout << fixed << setprecision(2) << mb << " MB, "
+    << tokens << " tokens in " << setprecision(3) << seconds << " s on " << pool.size() << " threads: "
+    << setprecision(1) << mb / seconds << " MB/s, " << setprecision(2) << tokens / seconds / 1e6 << " Mtokens/s" << endl;
+  return failed ? 1 : 0;
+}
+
+// one file lexed in chunks on every thread, then parsed and folded like the sequential way
+static int runParallel(const char *fileName, bool parse, bool fold, size_t threadCount)
+{
+  ParallelLexer lexer(threadCount);
+  lexer.readFile(fileName);
+  TokenStream stream;
+  bool lexed = lexer.tokenize(stream);
+  LineIndex lines(lexer.getText(), lexer.getTextLength());
+  if (!lexed)
+  {
+    cerr << fileName << ": " << describeLexerError(lexer.getState(), lexer.getOffset(), lines) << endl;
+    return 1;
+  }
+  if (!parse)
+    return 0;
+
+  TokenView tokens = stream.view();
+  Syntax tree;
+  Parser parser(tokens);
+  if (!checkParser(fileName, parser, parser.parse(tree), tokens, lines))
+    return 1;
+  return (!fold || checkFolder(fileName, tree, tokens, lines)) ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+  LexerEngine engine = TABLE_DRIVEN;
+  bool parallel = false;
+  bool printStats = false;
+  bool parse = false;
+  bool fold = false;
+  bool pipeline = false;
+  size_t threadCount = 0;
+  const char *cacheDirectory = nullptr;
+  const char *traceFile = nullptr;
+  bool hasInputs = false;
+  vector<string> files;
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--cascade"))
+      engine = MATCHER_CASCADE;
+    else if (!strcmp(argv[i], "--parallel"))
+      parallel = true;
+    else if (!strcmp(argv[i], "--stats"))
+      printStats = true;
+    else if (!strcmp(argv[i], "--parse"))
+      parse = true;
+    else if (!strcmp(argv[i], "--fold"))
+      parse = fold = true;
+    else if (!strcmp(argv[i], "--pipeline"))
+      pipeline = true;
+    else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+      threadCount = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--cache") && i + 1 < argc)
+      cacheDirectory = argv[++i];
+    else if (!strcmp(argv[i], "--trace") && i + 1 < argc)
+      traceFile = argv[++i];
+    else if (argv[i][0] != '-')
+    {
+      // a file, a directory of .ag files or @list
+      hasInputs = true;
+      if (!addSourceFiles(argv[i], files))
+      {
+        cerr << argv[i] << ": can't be read" << endl;
+        return 1;
+      }
+    }
+  }
+
+  // the chunks are lexed by table driven lexers of their own, which keep no stats or trace
+  if (parallel && (engine != TABLE_DRIVEN || printStats || pipeline || traceFile))
+  {
+    cerr << "--parallel can't be used with --cascade, --stats, --pipeline or --trace" << endl;
+    return 1;
+  }
+
+  if (!hasInputs)
+    files.push_back("input.ag");
+  if (files.empty())
+  {
+    cerr << "no .ag files to lex" << endl;
+    return 1;
+  }
+  // tokenize always runs the automaton, so only a single file lexed on its own goes through
+  // the cascade
+  if (engine == MATCHER_CASCADE && (parse || pipeline || cacheDirectory || files.size() > 1))
+  {
+    cerr << "--cascade only lexes a single file, it can't be used with --parse, --fold, --pipeline or --cache" << endl;
+    return 1;
+  }
+  // a cache is only looked up file by file, so a single file with one goes the batch way too
+  if (cacheDirectory)
+  {
+    TokenCache cache(cacheDirectory);
+    return runBatch(files, parse, fold, printStats, threadCount, &cache);
+  }
+  if (files.size() > 1)
+    return runBatch(files, parse, fold, printStats, threadCount, nullptr);
+
+  const char *fileName = files[0].c_str();
+  if (parallel)
+    return runParallel(fileName, parse, fold, threadCount);
+
+  LexerStats stats;
+  Lexer lexer(fileName, engine);
+  if (printStats)
+    lexer.setStats(&stats);
+
+  if (pipeline)
+  {
+    // the lexer runs on a second thread while this one parses what it has already lexed
+    TokenRing ring;
+    TokenStream stream;
+    stream.setSource(lexer.getText());
+    thread producer([&]() { lexer.tokenize(ring); });
+
+    Syntax tree;
+    Parser parser(ring, stream);
+    bool parsed = parser.parse(tree);
+    producer.join();
+
+    if (lexer.getState() == PARSING) // stopped halfway by the parser giving up
+      return checkParser(fileName, parser, parsed, stream.view(), lexer.getLineIndex()) ? 0 : 1;
+    if (!checkLexer(fileName, lexer, printStats ? &stats : nullptr) || !checkParser(fileName, parser, parsed, stream.view(), lexer.getLineIndex()))
+      return 1;
+    return (!fold || checkFolder(fileName, tree, stream.view(), lexer.getLineIndex())) ? 0 : 1;
+  }
+
+  TokenStream stream;
+  if (parse)
+    lexer.tokenize(stream);
+  else if (engine == MATCHER_CASCADE)
+  {
+    while (lexer.getNextToken() != nullptr)
+      ;
+  }
+  else
+  {
+    vector<Lexeme> tokens(TOKEN_BATCH_SIZE);
+    size_t count;
+    while (lexer.getNextTokens(&tokens[0], tokens.size(), count) == BATCH_OK)
+      ;
+  }
+
+  bool lexed = checkLexer(fileName, lexer, printStats ? &stats : nullptr);
+  if (printStats)
+    lexer.getTrace().print(cout);
+  // only a lexer built with a trace policy that keeps events has any to write
+  if (traceFile && !lexer.getTrace().write(traceFile))
+    cerr << traceFile << ": no trace written" << endl;
+  if (!lexed)
+    return 1;
+
+  if (parse)
+  {
+    TokenView tokens = stream.view();
+    Syntax tree;
+    Parser parser(tokens);
+    if (!checkParser(fileName, parser, parser.parse(tree), tokens, lexer.getLineIndex()))
+      return 1;
+    if (fold && !checkFolder(fileName, tree, tokens, lexer.getLineIndex()))
+      return 1;
+  }
   return 0;
-}
\ No newline at end of file
+}
@@ -1,72 +1,102 @@
 #include "Lexer.h"
-#include <boost\regex.hpp>
+#include "CharScan.h"
+#include "TokenRing.h"
 #include <string>
-#include <sstream>
+#include <cstring>
 
 using namespace std;
 
 _LEX_BEGIN
 
 const CharToDigit Lexer::charToDigit;
+const ScannerTables Lexer::scannerTables;
 
-int find_match_offset(std::string const& string_to_search, boost::regex const& expression)
+Lexer::Lexer(const char *fileName, LexerEngine engine, Arena *region) : symbols(&symbolNames), engine(engine)
 {
-  boost::smatch results;
-  if (boost::regex_match(string_to_search, results, expression))
-  {
-    int len = results.length();
-    return results.position();
-  }
-  return -1;
+  init(region);
+  readFile(fileName);
 }
 
-Lexer::Lexer(const char *fileName) : currentLine(1)
+Lexer::Lexer(const char *data, size_t length, LexerEngine engine, Arena *region) : symbols(&symbolNames), engine(engine)
 {
-  lexemeStart = new LexemeStart;
-  currentTable = new SymbolTable;
-  readFile(fileName);
+  init(region);
+  source.assign(data, length);
+  onSourceLoaded();
 }
 
-bool Lexer::readFile(const char *fileName)
+void Lexer::init(Arena *r)
 {
-  ifstream in(fileName, std::ios::in);
-  in.close();
-  in.open(fileName, ios::in);
+  region = r ? r : &ownRegion;
+  s = source.data();
+  sourceLength = 0;
+  currentIndex = 0;
+  tokenStart = 0;
+  state = FINISHED;
+  deferSymbols = false;
+  validateInput = true;
+  stats = nullptr;
+}
 
-  bool retVal = true;
-  if (in)
-  {
-    std::stringstream buffer;
-    buffer << in.rdbuf();
-    s = buffer.str();
-    s.push_back(0); // assume \0 will never appear as a character in any lexeme so it interrupts any lexeme recognition
-    currentIndex = 0;
-    state = PARSING;
-  }
-  else
+// a new file is a unit of its own: its scopes and names start empty, so a lexer kept for
+// file after file holds no more than the largest of them needs
+bool Lexer::readFile(const char *fileName)
+{
+  symbols.clear();
+  symbolNames.clear();
+  decodedLiterals.clear();
+  if (region == &ownRegion) // the tokens of the last text go with it
+    ownRegion.reset();
+  if (!source.mapFile(fileName))
   {
     state = WRONG_FILE;
-    retVal = false;
+    return false;
   }
 
-  return retVal;
+  onSourceLoaded();
+  return true;
 }
 
-int Lexer::getSign()
+void Lexer::setText(const char *data, size_t length)
 {
-  switch (s[currentIndex])
+  symbols.clear();
+  symbolNames.clear();
+  decodedLiterals.clear();
+  if (region == &ownRegion)
+    ownRegion.reset();
+  source.assign(data, length);
+  onSourceLoaded();
+}
+
+// \0 is assumed never to appear inside a lexeme, so the sentinel behind the text stops any recognition;
+// offsets are kept in 32 bits, a larger text isn't taken. The whole text is checked to be UTF-8
+// before the first lexeme, so the scanner can take it for granted in names and literals
+void Lexer::onSourceLoaded()
+{
+  s = source.data();
+  sourceLength = source.size();
+  currentIndex = 0;
+  lines.reset(s, sourceLength);
+  state = (sourceLength <= UINT32_MAX) ? PARSING : WRONG_FILE;
+  if (state == PARSING && validateInput)
   {
-  case '+':
-    currentIndex++;
-    return 1;
-  case '-':
-    currentIndex++;
-    return -1;
-  default:
-    return 1;
+    size_t invalid = findInvalidUtf8(s, s + sourceLength) - s;
+    if (invalid != sourceLength)
+    {
+      state = WRONG_ENCODING;
+      currentIndex = invalid;
+    }
   }
 }
 
+// lexes only [begin, end) of the loaded text; end has to be a blank outside any comment or
+// literal, so no lexeme crosses it
+void Lexer::setRange(size_t begin, size_t end)
+{
+  currentIndex = begin;
+  sourceLength = end;
+  state = PARSING;
+}
+
 Token *deattachToken(TokenData * d)
 {
   Token * token = d->deattachToken();
@@ -74,21 +104,430 @@ Token *deattachToken(TokenData * d)
   return token;
 }
 
+static bool isFollowAllowed(TokenType type, char c)
+{
+  switch (type)
+  {
+  case INTEGER:
+  case FLOAT:
+  case LITERAL:
+  case BOOL:
+    return Operand::isCharacterPossibleAfterToken(c);
+  case COMPARISON:
+  case ARITHMETIC:
+  case SHIFT:
+  case BITWISE_BINARY:
+  case BITWISE_NOT:
+  case LOGIC_BINARY:
+  case LOGIC_NOT:
+  case ASSIGNMENT:
+    return Operator::isCharacterPossibleAfterToken(c);
+  case LEFT_RND_BRACKET:
+  case LEFT_SQR_BRACKET:
+    return OpenBracket::isCharacterPossibleAfterToken(c);
+  case RIGHT_RND_BRACKET:
+  case RIGHT_SQR_BRACKET:
+    return CloseBracket::isCharacterPossibleAfterToken(c);
+  default: // identifiers are checked once they are told apart from keywords
+    return true;
+  }
+}
+
 Token *Lexer::getNextToken()
+{
+  if (engine == MATCHER_CASCADE)
+  {
+    if (state != PARSING)
+      return nullptr;
+    Token *token = getNextTokenByMatchers();
+    if (token)
+    {
+      token->offset = static_cast<uint32_t>(tokenStart);
+      token->length = static_cast<uint32_t>(currentIndex - tokenStart);
+      if (stats)
+        stats->tokens[token->getType()]++;
+    }
+    return token;
+  }
+
+  Lexeme lexeme;
+  if (!scan(lexeme))
+    return nullptr;
+  if (stats)
+  {
+    stats->tokens[lexeme.type]++;
+    stats->regionTokens++;
+  }
+  Token *token = makeToken(lexeme);
+  token->offset = lexeme.offset;
+  token->length = lexeme.length;
+  return token;
+}
+
+BatchStatus Lexer::getNextTokens(Lexeme *tokens, size_t capacity, size_t &count)
+{
+  count = 0;
+  while (count < capacity && scan(tokens[count]))
+  {
+    if (stats)
+      stats->tokens[tokens[count].type]++;
+    count++;
+  }
+
+  if (count == capacity)
+    return BATCH_OK;
+  return (state == FINISHED) ? BATCH_END : BATCH_ERROR;
+}
+
+// appends every remaining token to the stream, false if lexing stopped on an error
+bool Lexer::tokenize(TokenStream &stream)
+{
+  stream.setSource(s);
+
+  Lexeme lexeme;
+  while (scan(lexeme))
+  {
+    if (stats)
+      stats->tokens[lexeme.type]++;
+    stream.push(lexeme);
+  }
+
+  return state == FINISHED;
+}
+
+// runs on a thread of its own, a batch at a time so the consumer sees tokens early
+bool Lexer::tokenize(TokenRing &ring)
+{
+  const size_t RING_BATCH_SIZE = 256;
+
+  Lexeme *slots;
+  size_t room;
+  while ((room = ring.reserve(slots, RING_BATCH_SIZE)) != 0)
+  {
+    size_t count;
+    BatchStatus status = getNextTokens(slots, room, count);
+    ring.commit(count);
+    if (status != BATCH_OK)
+      break;
+  }
+
+  ring.close();
+  return state == FINISHED;
+}
+
+// runs the automaton from currentIndex as far as it goes and takes the longest accepted prefix
+bool Lexer::scan(Lexeme &lexeme)
+{
+  if (state != PARSING)
+    return false;
+
+  skipSpaces();
+  if (state == FINISHED)
+    return false;
+
+  const char *text = s;
+  const ScannerTables &tables = scannerTables;
+  size_t pos = currentIndex;
+  size_t acceptEnd = currentIndex;
+  unsigned char acceptState = S_DEAD;
+  unsigned char current = S_START;
+  uint32_t nameHash = 0;
+  bool hasEscapes = false;
+
+  while (true)
+  {
+    current = tables.next[current][tables.charClass[static_cast<unsigned char>(text[pos])]];
+    if (current == S_DEAD)
+      break;
+    pos++;
+    if (current == S_IDENTIFIER) // the rest of an identifier is skipped a word at a time
+    {
+      pos = scanIdentifier(text + currentIndex, text + sourceLength, nameHash) - text;
+      if (pos > currentIndex) // else a code point that can't start a name
+      {
+        acceptState = current;
+        acceptEnd = pos;
+      }
+      break;
+    }
+    if (current == S_STRING) // so is the body of a literal
+    {
+      const char *close = scanStringBody(text + pos, text + sourceLength, hasEscapes);
+      if (*close == '"')
+      {
+        acceptState = S_STRING_END;
+        acceptEnd = close + 1 - text;
+      }
+      break;
+    }
+    if (tables.isAccepting(current))
+    {
+      acceptState = current;
+      acceptEnd = pos;
+    }
+  }
+
+  if (acceptState == S_DEAD)
+  {
+    onErrorToken();
+    return false;
+  }
+  if (stats && pos > acceptEnd)
+  {
+    stats->backtracks++;
+    stats->backtrackedBytes += pos - acceptEnd;
+  }
+
+  lexeme.type = static_cast<TokenType>(tables.acceptType[acceptState]);
+  lexeme.subtype = tables.acceptSubtype[acceptState];
+  lexeme.offset = static_cast<uint32_t>(currentIndex);
+  lexeme.length = static_cast<uint32_t>(acceptEnd - currentIndex);
+  lexeme.symbolIndex = 0;
+  lexeme.scope = 0;
+
+  if (!isFollowAllowed(lexeme.type, text[acceptEnd]))
+  {
+    onErrorToken();
+    return false;
+  }
+  currentIndex = acceptEnd;
+
+  switch (lexeme.type)
+  {
+  case INTEGER:
+    {
+      int base = lexeme.subtype;
+      size_t prefix = (base == 10) ? 0 : 2;
+      if (parseInteger(text + lexeme.offset + prefix, lexeme.length - prefix, base, lexeme.intValue) != NUMBER_OK)
+      {
+        state = CONSTANT_OVERFLOW; // the automaton only lets digits of the base through
+        currentIndex = lexeme.offset;
+        return false;
+      }
+    }
+    break;
+  case FLOAT:
+    {
+      size_t length = lexeme.length;
+      if (text[lexeme.offset + length - 1] > '9') // suffix
+        length--;
+      NumberStatus status = (lexeme.subtype == Float::DOUBLE)
+        ? parseDouble(text + lexeme.offset, length, lexeme.doubleValue)
+        : parseFloat(text + lexeme.offset, length, lexeme.floatValue);
+      if (status != NUMBER_OK)
+      {
+        state = CONSTANT_OVERFLOW;
+        currentIndex = lexeme.offset;
+        return false;
+      }
+    }
+    break;
+  case LITERAL:
+    if (hasEscapes)
+      lexeme.subtype = Literal::ESCAPED;
+    break;
+  case IDENTIFIER:
+    return onIdentifier(lexeme, nameHash);
+  default: // the rest carry nothing beyond type and subtype
+    break;
+  }
+
+  return true;
+}
+
+bool Lexer::onIdentifier(Lexeme &lexeme, uint32_t hash)
+{
+  const char *name = s + lexeme.offset;
+  KeywordInfo word = classifyWord(name, lexeme.length);
+
+  if (word.type == RESERVED)
+  {
+    if (!onReservedWord(static_cast<ReservedWord::ReservedType>(word.value)))
+      return false;
+    lexeme.type = RESERVED;
+    lexeme.subtype = word.value;
+    return true;
+  }
+
+  // a boolean that can't stand here is read as a plain name, as the matchers always did
+  if (word.type == BOOL && Boolean::isCharacterPossibleAfterToken(s[currentIndex]))
+  {
+    lexeme.type = BOOL;
+    lexeme.boolValue = word.value != 0;
+    return true;
+  }
+
+  if (deferSymbols)
+  {
+    lexeme.symbolIndex = symbolNames.intern(name, lexeme.length, hash);
+    return true;
+  }
+
+  lexeme.symbolIndex = putSymbol(name, lexeme.length, hash);
+  lexeme.scope = symbols.getScope();
+  return true;
+}
+
+uint32_t Lexer::putSymbol(const char *name, size_t length, uint32_t hash)
+{
+  if (!stats)
+    return symbols.put(DataType::UNKNOWN, name, length, hash);
+
+  size_t known = symbols.size();
+  uint32_t symbol = symbols.put(DataType::UNKNOWN, name, length, hash);
+  if (symbol < known)
+    stats->symbolHits++;
+  else
+    stats->symbolMisses++;
+  return symbol;
+}
+
+StringSpan Lexer::getLiteralValue(const Literal &literal)
+{
+  if (literal.type == Literal::PLAIN)
+    return literal.text;
+  return decodeLiteral(literal.text);
+}
+
+StringSpan Lexer::getLiteralValue(const TokenRef &token)
+{
+  StringSpan text(token.getText() + 1, token.getLength() - 2);
+  if (token.getSubtype() == Literal::PLAIN)
+    return text;
+  return decodeLiteral(text);
+}
+
+// escaped literals are decoded once, on first request, into the lexer's arena
+StringSpan Lexer::decodeLiteral(StringSpan text)
+{
+  size_t offset = text.data - s;
+  std::map<size_t, StringSpan>::iterator it = decodedLiterals.find(offset);
+  if (it != decodedLiterals.end())
+    return it->second;
+
+  char *out = static_cast<char *>(region->allocate(text.length + 1, 1));
+  size_t length = decodeEscapes(text.data, text.length, out);
+  out[length] = 0;
+
+  StringSpan value(out, length);
+  decodedLiterals[offset] = value;
+  return value;
+}
+
+Token *Lexer::makeToken(const Lexeme &lexeme)
+{
+  switch (lexeme.type)
+  {
+  case INTEGER:
+    return new (*region) Integer(lexeme.intValue);
+  case FLOAT:
+    if (lexeme.subtype == Float::DOUBLE)
+      return new (*region) Float(lexeme.doubleValue);
+    return new (*region) Float(lexeme.floatValue);
+  case LITERAL:
+    return new (*region) Literal(StringSpan(s + lexeme.offset + 1, lexeme.length - 2), static_cast<Literal::LiteralType>(lexeme.subtype));
+  case BOOL:
+    return new (*region) Boolean(lexeme.boolValue);
+  case IDENTIFIER:
+    return new (*region) Identifier(lexeme.symbolIndex, lexeme.scope);
+  case RESERVED:
+    return new (*region) ReservedWord(static_cast<ReservedWord::ReservedType>(lexeme.subtype));
+  case COMPARISON:
+    return new (*region) Comparison(static_cast<Comparison::ComparisonType>(lexeme.subtype));
+  case ARITHMETIC:
+    return new (*region) Arithmetic(static_cast<Arithmetic::ArithmeticType>(lexeme.subtype));
+  case SHIFT:
+    return new (*region) Shift(static_cast<Shift::ShiftType>(lexeme.subtype));
+  case BITWISE_BINARY:
+    return new (*region) BitwiseBinary(static_cast<BitwiseBinary::BitwiseType>(lexeme.subtype));
+  case BITWISE_NOT:
+    return new (*region) BitwiseNot();
+  case LOGIC_BINARY:
+    return new (*region) LogicBinary(static_cast<LogicBinary::LogicType>(lexeme.subtype));
+  case LOGIC_NOT:
+    return new (*region) LogicNot();
+  case ASSIGNMENT:
+    return new (*region) Assignment();
+  case LEFT_RND_BRACKET:
+    return new (*region) LeftRoundBracket();
+  case RIGHT_RND_BRACKET:
+    return new (*region) RightRoundBracket();
+  case LEFT_SQR_BRACKET:
+    return new (*region) LeftSquareBracket();
+  case RIGHT_SQR_BRACKET:
+    return new (*region) RightSquareBracket();
+  case SEMICOLON:
+    return new (*region) Semicolon();
+  case COMMA:
+    return new (*region) Comma();
+  }
+  return nullptr;
+}
+
+// handles scope keywords; false means the word can't appear here
+bool Lexer::onReservedWord(ReservedWord::ReservedType type)
+{
+  if (deferSymbols)
+    return true;
+
+  switch (type)
+  {
+  case ReservedWord::BEGIN:
+    symbols.enterScope();
+    break;
+  case ReservedWord::END:
+    if (!symbols.exitScope())
+    {
+      state = LexerState::SYNTAX_ERROR;
+      return false;
+    }
+    break;
+  default:
+    break;
+  }
+
+  return true;
+}
+
+TokenData *Lexer::countMatch(Matcher matcher, TokenData *data)
+{
+  if (stats)
+  {
+    stats->matcherAttempts[matcher]++;
+    if (data->hasNullToken())
+      stats->matcherFailures[matcher]++;
+  }
+  return data;
+}
+
+// a matcher between the hooks of the trace policy; the matcher is a template argument, so it
+// is called directly, and with NullTrace nothing but that call remains
+template <Matcher M, TokenData *(Lexer::*Match)()>
+TokenData *Lexer::runMatcher()
+{
+  TracePolicy::Mark start = trace.begin();
+  size_t from = currentIndex;
+  TokenData *data = countMatch(M, (this->*Match)());
+  trace.endMatch(start, M, data->getToken(), currentIndex - from);
+  return data;
+}
+
+Token *Lexer::getNextTokenByMatchers()
 {
   skipSpaces();
+  tokenStart = currentIndex;
   if (state == FINISHED)
     return nullptr;
 
   TokenData *data = nullptr;
   if (s[currentIndex] == '<' || s[currentIndex] == '>')
   {
-    data = getComparisonToken();
+    data = runMatcher<MATCH_COMPARISON, &Lexer::getComparisonToken>();
     if (!data->hasNullToken())
       return (deattachToken(data));
     delete data;
     
-    data = getShiftToken();
+    data = runMatcher<MATCH_SHIFT, &Lexer::getShiftToken>();
     if (!data->hasNullToken())
       return (deattachToken(data));
     delete data;
@@ -96,129 +535,146 @@ Token *Lexer::getNextToken()
     return onErrorToken();
   }
 
+  // == and != before the assignment and logic not matchers take their first character
+  if (s[currentIndex] == '=' || s[currentIndex] == '!')
+  {
+    data = runMatcher<MATCH_COMPARISON, &Lexer::getComparisonToken>();
+    if (!data->hasNullToken())
+      return (deattachToken(data));
+    delete data;
+  }
+
   if (s[currentIndex] >= '0' && s[currentIndex] <= '9')
   {
-    data = getIntegerToken();
+    data = runMatcher<MATCH_INTEGER, &Lexer::getIntegerToken>();
     if (!data->hasNullToken())
       return (deattachToken(data));
     delete data;
 
-    data = getFloatToken(); // add flags like f to determine floats
+    data = runMatcher<MATCH_FLOAT, &Lexer::getFloatToken>();
     if (!data->hasNullToken())
       return (deattachToken(data));
     delete data;
   }
  
-  data = getArithmeticToken();
+  data = runMatcher<MATCH_ARITHMETIC, &Lexer::getArithmeticToken>();
   if (!data->hasNullToken())
     return (deattachToken(data));
   delete data;
 
-  data = getLogicBinaryToken();
+  data = runMatcher<MATCH_LOGIC_BINARY, &Lexer::getLogicBinaryToken>();
   if (!data->hasNullToken())
     return (deattachToken(data));
   delete data;
 
-  data = getBitwiseBinaryToken();
+  data = runMatcher<MATCH_BITWISE_BINARY, &Lexer::getBitwiseBinaryToken>();
   if (!data->hasNullToken())
     return (deattachToken(data));
   delete data;
 
-  data = getLogicNotToken();
+  data = runMatcher<MATCH_LOGIC_NOT, &Lexer::getLogicNotToken>();
   if (!data->hasNullToken())
     return (deattachToken(data));
   delete data;
 
-  data = getBitwiseNotToken();
+  data = runMatcher<MATCH_BITWISE_NOT, &Lexer::getBitwiseNotToken>();
   if (!data->hasNullToken())
     return (deattachToken(data));
   delete data;
 
-  data = getBooleanData();
+  data = runMatcher<MATCH_BOOLEAN, &Lexer::getBooleanData>();
   if (!data->hasNullToken())
     return (deattachToken(data));
   delete data;
 
-  data = getAssignmentToken();
+  data = runMatcher<MATCH_ASSIGNMENT, &Lexer::getAssignmentToken>();
   if (!data->hasNullToken())
     return (deattachToken(data));
   delete data;
 
-  data = getLiteralToken();
+  data = runMatcher<MATCH_LITERAL, &Lexer::getLiteralToken>();
   if (!data->hasNullToken())
     return (deattachToken(data));
   delete data;
 
-  data = getIdentifierToken();
+  data = runMatcher<MATCH_IDENTIFIER, &Lexer::getIdentifierToken>();
   if (!data->hasNullToken())
     return (deattachToken(data));
   delete data;
 
-  return nullptr;
+  data = runMatcher<MATCH_PUNCTUATION, &Lexer::getPunctuationToken>();
+  if (!data->hasNullToken())
+    return (deattachToken(data));
+  delete data;
+
+  if (state != PARSING) // a constant that didn't fit has already said why
+    return nullptr;
+  return onErrorToken();
 }
 
 void Lexer::skipSpaces()
 {
-  bool isSingleLineComment = false;
-  bool isMultilineComment = false;
-  char prevSymbol = 0;
+  TracePolicy::Mark start = trace.begin();
+  const char *p = s + currentIndex;
+  const char *end = s + sourceLength;
+  size_t commentBytes = 0;
 
   while (true)
   {
-    switch (s[currentIndex])
-    {
-    case '/':
-      if (prevSymbol == '/' && !isMultilineComment && !isSingleLineComment)
-        isSingleLineComment = true;
-
-      else if (prevSymbol == '*' && isMultilineComment)
-        isMultilineComment = false;
+    p = skipBlanks(p, end);
+    if (p + 1 >= end || p[0] != '/')
       break;
-    case '*':
-      if (!isSingleLineComment && !isMultilineComment)
-      {
-        if (prevSymbol != '/')
-          return;
-        isMultilineComment = true;
-      }
-      break;
-    case '\n':
-      currentLine++;
-      isSingleLineComment = false;
-      break;
-    case ' ':
-    case '\t':
-    case '\r':
-      break;
-    case 0:
-      state = FINISHED;
-      return;
-    default:
-      if (isSingleLineComment || isMultilineComment)
-        break;
-      return;
-    }
-    prevSymbol = s[currentIndex++];
+
+    const char *comment = p;
+    if (p[1] == '/')
+      p = findLineEnd(p + 2, end);
+    else if (p[1] == '*')
+      p = skipBlockComment(p + 2, end);
+    else
+      break; // a lone slash is the division operator
+    commentBytes += p - comment;
+  }
+
+  if (stats)
+  {
+    stats->commentBytes += commentBytes;
+    stats->whitespaceBytes += (p - s) - currentIndex - commentBytes;
   }
+  trace.endSkip(start, (p - s) - currentIndex);
+  currentIndex = p - s;
+  if (p == end || *p == 0)
+    state = FINISHED;
 }
 
 void Lexer::onStartMatch()
 {
-  lexemeStart->pos.push_back(currentIndex);
+  lexemeStart.pos.push_back(currentIndex);
 }
 
 TokenData * Lexer::onEndMatch(Token *token)
 {
   size_t endIndex = currentIndex;
   if (token == nullptr)
-    currentIndex = lexemeStart->pos.back();
-  lexemeStart->pos.pop_back();
+    currentIndex = lexemeStart.pos.back();
+  lexemeStart.pos.pop_back();
+
+  if (stats)
+  {
+    stats->tokenDataAllocations++;
+    if (token != nullptr)
+      stats->regionTokens++;
+    else if (endIndex != currentIndex)
+    {
+      stats->backtracks++;
+      stats->backtrackedBytes += endIndex - currentIndex;
+    }
+  }
   return new TokenData(token, endIndex - currentIndex);
 }
 
 Token *Lexer::onErrorToken()
 {
-
+  state = SYNTAX_ERROR;
   return nullptr;
 }
 
@@ -233,11 +689,9 @@ TokenData *Lexer::getIntegerToken()
   int base = 10;
   int num = 0;
 
-  //int pos = find_match_offset(s.substr(currentIndex), e4);
-
   onStartMatch();
 
-  if (s[currentIndex] == '0') // not 10 base
+  if (s[currentIndex] == '0' && !isDecimalDigit(s[currentIndex + 1])) // not 10 base, or zero alone
   {
     switch (s[++currentIndex])
     {
@@ -254,13 +708,18 @@ TokenData *Lexer::getIntegerToken()
       base = 2;
       break;
     case '.': // it's probably floating point number
+    case 'e':
+    case 'E':
       return onEndMatch();
     default: // it's just signed zero
-      return onEndMatch(new Integer(0));
+      if (!Integer::isCharacterPossibleAfterToken(s[currentIndex]))
+        return onEndMatch();
+      return onEndMatch(new (*region) Integer(0));
     }
     currentIndex++;
   }
 
+  size_t digitsStart = currentIndex;
   num = charToDigit.getDigit(s[currentIndex++]);
   if (num == -1 || num >= base)  // number with x, b or q must not contain 0 digits after letter
     return onEndMatch();
@@ -274,87 +733,90 @@ TokenData *Lexer::getIntegerToken()
     if (digit >= base) // can't be if it's not an error
       return onEndMatch();
 
-    num *= base;
-    num += digit;
     currentIndex++;
   }
 
   if (!Integer::isCharacterPossibleAfterToken(s[currentIndex]))
     return onEndMatch(); 
 
-  return onEndMatch(new Integer(num));
+  if (parseInteger(s + digitsStart, currentIndex - digitsStart, base, num) != NUMBER_OK)
+  {
+    state = CONSTANT_OVERFLOW;
+    return onEndMatch();
+  }
+
+  return onEndMatch(new (*region) Integer(num));
 }
 
 TokenData *Lexer::getFloatToken()
 {
-  float base = 10.0f;
-  size_t intBase = static_cast<size_t>(base);
-  float invBase = 1.0f;
-  float num = 0;
-  size_t power = 0;
-  int sign = 1;
-  bool dotFound = false;
-  bool expFound = false;
-
   onStartMatch();
 
-  sign = getSign();
-
-  num = static_cast<float>(charToDigit.getDigit(s[currentIndex++]));
-  if (num == -1 || num >= base)  // number with x, b or q must not contain 0 digits after letter
+  // digits [. digits] [e [+-] digits], as the scanner's tables take it
+  size_t start = currentIndex;
+  while (isDecimalDigit(s[currentIndex]))
+    currentIndex++;
+  if (currentIndex == start)
     return onEndMatch();
 
-  while (true)
+  bool isFloat = false;
+  if (s[currentIndex] == '.')
   {
-    char c = s[currentIndex++];
-    int digit = charToDigit.getDigit(c);
-    if (digit == -1)  // number is read
+    isFloat = true;
+    currentIndex++;
+    while (isDecimalDigit(s[currentIndex]))
+      currentIndex++;
+  }
+
+  if (s[currentIndex] == 'e' || s[currentIndex] == 'E')
+  {
+    size_t exponent = currentIndex + 1;
+    if (s[exponent] == '+' || s[exponent] == '-')
+      exponent++;
+    if (isDecimalDigit(s[exponent]))
     {
-      switch (c)
-      {
-      case '.':
-        if (dotFound)
-          return onEndMatch();
-        dotFound = true;
-        continue;
-      default:
-        return onEndMatch(new Float(num));
-      }
+      isFloat = true;
+      currentIndex = exponent;
+      while (isDecimalDigit(s[currentIndex]))
+        currentIndex++;
     }
+  }
 
-    if (digit >= base) // can't be if it's not an error
-    {
-      if (digit != 0xe)
-        return onEndMatch();
+  if (!isFloat)
+    return onEndMatch();
 
-      if (expFound)
-        return onEndMatch();
-      expFound = true;
-    }
-    else
-    {
-      if (!dotFound && !expFound)
-      {
-        num *= base;
-        num += digit;
-      }
-      else if (dotFound && !expFound)
-      {
-        invBase /= base;
-        num += (digit * invBase);
-      }
-      else
-      {
-        power *= intBase;
-        num += digit;
-      }
-    }
+  size_t length = currentIndex - start;
+  Float::FloatType type = Float::SINGLE;
+  switch (s[currentIndex])
+  {
+  case 'd':
+  case 'D':
+    type = Float::DOUBLE;
+    // fall through
+  case 'f':
+  case 'F':
+    currentIndex++;
+    break;
   }
 
   if (!Float::isCharacterPossibleAfterToken(s[currentIndex]))
-    return onEndMatch(); 
+    return onEndMatch();
 
-  return onEndMatch(new Float(static_cast<float>(pow(base, power))));
+  if (type == Float::DOUBLE)
+  {
+    double value;
+    if (parseDouble(s + start, length, value) == NUMBER_OK)
+      return onEndMatch(new (*region) Float(value));
+  }
+  else
+  {
+    float value;
+    if (parseFloat(s + start, length, value) == NUMBER_OK)
+      return onEndMatch(new (*region) Float(value));
+  }
+
+  state = CONSTANT_OVERFLOW;
+  return onEndMatch();
 }
 
 TokenData *Lexer::getComparisonToken()
@@ -392,18 +854,17 @@ TokenData *Lexer::getComparisonToken()
     case Comparison::ComparisonType::GRE:
       type = Comparison::ComparisonType::GREQ;
       break;
+    default:
+      break;
     }
   }
-  else
-  {
-    if (type == Comparison::ComparisonType::EQ || type == Comparison::ComparisonType::NEQ)
-      return onEndMatch();
+  else if (type == Comparison::ComparisonType::EQ || type == Comparison::ComparisonType::NEQ)
+    return onEndMatch();
 
-    if (!Comparison::isCharacterPossibleAfterToken(s[currentIndex]))
-      return onEndMatch();
-  }
+  if (!Comparison::isCharacterPossibleAfterToken(s[currentIndex]))
+    return onEndMatch();
 
-  return onEndMatch(new Comparison(type));
+  return onEndMatch(new (*region) Comparison(type));
 }
 
 TokenData *Lexer::getShiftToken()
@@ -433,7 +894,7 @@ TokenData *Lexer::getShiftToken()
   if (!Shift::isCharacterPossibleAfterToken(s[currentIndex]))
     return onEndMatch();
 
-  return onEndMatch(new Shift(type));
+  return onEndMatch(new (*region) Shift(type));
 }
 
 TokenData *Lexer::getArithmeticToken()
@@ -443,6 +904,8 @@ TokenData *Lexer::getArithmeticToken()
 
   switch (s[currentIndex++])
   {
+  case '+':
+    break;
   case '-':
     type = Arithmetic::MINUS;
     break;
@@ -462,7 +925,43 @@ TokenData *Lexer::getArithmeticToken()
   if (!Arithmetic::isCharacterPossibleAfterToken(s[currentIndex]))
     return onEndMatch();
 
-  return onEndMatch(new Arithmetic(type));
+  return onEndMatch(new (*region) Arithmetic(type));
+}
+
+TokenData *Lexer::getPunctuationToken()
+{
+  onStartMatch();
+
+  Token *token = nullptr;
+  switch (s[currentIndex++])
+  {
+  case '(':
+    if (OpenBracket::isCharacterPossibleAfterToken(s[currentIndex]))
+      token = new (*region) LeftRoundBracket();
+    break;
+  case ')':
+    if (CloseBracket::isCharacterPossibleAfterToken(s[currentIndex]))
+      token = new (*region) RightRoundBracket();
+    break;
+  case '[':
+    if (OpenBracket::isCharacterPossibleAfterToken(s[currentIndex]))
+      token = new (*region) LeftSquareBracket();
+    break;
+  case ']':
+    if (CloseBracket::isCharacterPossibleAfterToken(s[currentIndex]))
+      token = new (*region) RightSquareBracket();
+    break;
+  case ';':
+    token = new (*region) Semicolon();
+    break;
+  case ',':
+    token = new (*region) Comma();
+    break;
+  default:
+    break;
+  }
+
+  return onEndMatch(token);
 }
 
 TokenData *Lexer::getBitwiseBinaryToken()
@@ -472,6 +971,8 @@ TokenData *Lexer::getBitwiseBinaryToken()
   BitwiseBinary::BitwiseType type = BitwiseBinary::AND;
   switch (s[currentIndex++])
   {
+  case '&':
+    break;
   case '|':
     type = BitwiseBinary::OR;
     break;
@@ -485,7 +986,7 @@ TokenData *Lexer::getBitwiseBinaryToken()
   if (!BitwiseBinary::isCharacterPossibleAfterToken(s[currentIndex]))
     return onEndMatch();
 
-  return onEndMatch(new BitwiseBinary(type));
+  return onEndMatch(new (*region) BitwiseBinary(type));
 }
 
 TokenData *Lexer::getBitwiseNotToken()
@@ -498,7 +999,7 @@ TokenData *Lexer::getBitwiseNotToken()
   if (!BitwiseNot::isCharacterPossibleAfterToken(s[currentIndex]))
     return onEndMatch();
 
-  return onEndMatch(new BitwiseNot());
+  return onEndMatch(new (*region) BitwiseNot());
 }
 
 TokenData *Lexer::getLogicBinaryToken()
@@ -524,7 +1025,7 @@ TokenData *Lexer::getLogicBinaryToken()
   if (!LogicBinary::isCharacterPossibleAfterToken(s[currentIndex]))
     return onEndMatch();
 
-  return onEndMatch(new LogicBinary(type));
+  return onEndMatch(new (*region) LogicBinary(type));
 }
 
 TokenData *Lexer::getLogicNotToken()
@@ -537,7 +1038,7 @@ TokenData *Lexer::getLogicNotToken()
   if (!LogicNot::isCharacterPossibleAfterToken(s[currentIndex]))
     return onEndMatch();
 
-  return onEndMatch(new LogicNot());
+  return onEndMatch(new (*region) LogicNot());
 }
 
 TokenData *Lexer::getAssignmentToken()
@@ -550,37 +1051,29 @@ TokenData *Lexer::getAssignmentToken()
   if (!Assignment::isCharacterPossibleAfterToken(s[currentIndex]))
     return onEndMatch();
 
-  return onEndMatch(new Assignment());
+  return onEndMatch(new (*region) Assignment());
 }
 
 TokenData *Lexer::getLiteralToken()
 {
   onStartMatch();
 
-  char *lit = nullptr;
-
   if (s[currentIndex++] != '"')
     return onEndMatch();
 
   size_t startIndex = currentIndex;
-  while (currentIndex < s.size())
-  {
-    if (s[currentIndex] == '"' && s[currentIndex] != '\\')
-      break;
-    currentIndex++;
-  }
+  bool hasEscapes = false;
+  currentIndex = scanStringBody(s + currentIndex, s + sourceLength, hasEscapes) - s;
 
-  if (currentIndex == s.size())
+  if (s[currentIndex] != '"')
     return onEndMatch();
+  currentIndex++;
 
-  // s[currentIndex] == '"'
-  if (!Literal::isCharacterPossibleAfterToken(s[currentIndex + 1]))
+  if (!Literal::isCharacterPossibleAfterToken(s[currentIndex]))
     return onEndMatch();
 
-  lit = new char[currentIndex - startIndex];
-  strcpy(lit, s.substr(startIndex, currentIndex - startIndex - 1).c_str());
-
-  return onEndMatch(new Literal(lit));
+  StringSpan text(s + startIndex, currentIndex - startIndex - 1);
+  return onEndMatch(new (*region) Literal(text, hasEscapes ? Literal::ESCAPED : Literal::PLAIN));
 }
 
 TokenData *Lexer::getBooleanData()
@@ -589,12 +1082,12 @@ TokenData *Lexer::getBooleanData()
 
   bool value = false;
 
-  if (!s.compare(currentIndex, 4, "true"))
+  if (!strncmp(s + currentIndex, "true", 4))
   {
     value = true;
     currentIndex += 4;
   }
-  else if (s.compare(currentIndex, 5, "false"))
+  else if (strncmp(s + currentIndex, "false", 5))
     return onEndMatch();
   else
     currentIndex += 5;
@@ -602,7 +1095,7 @@ TokenData *Lexer::getBooleanData()
   if (!Boolean::isCharacterPossibleAfterToken(s[currentIndex]))
     return onEndMatch();
 
-  return onEndMatch(new Boolean(value));
+  return onEndMatch(new (*region) Boolean(value));
 }
 
 /*TokenData *Lexer::getKeyWord()
@@ -613,49 +1106,29 @@ TokenData *Lexer::getBooleanData()
 
 TokenData *Lexer::getIdentifierToken()
 {
-  static const boost::regex e("^([a-zA-Z_][a-zA-Z0-9_]*).*");
   onStartMatch();
 
-  boost::match_results<const char *> results;
-  if (boost::regex_match(s.c_str() + currentIndex, results, e))
+  char c = s[currentIndex];
+  if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || static_cast<unsigned char>(c) >= 0x80)
   {
-    std::string name = results[1];
-    int len = name.length();
-    currentIndex += len;
+    size_t startIndex = currentIndex;
+    uint32_t hash;
+    currentIndex = scanIdentifier(s + currentIndex, s + sourceLength, hash) - s;
+    size_t length = currentIndex - startIndex;
+    if (length == 0) // a code point that can't start a name
+      return onEndMatch();
 
-    SymbolData data;
-    
-    int index = currentTable->put(SymbolData(DataType::UNKNOWN, name));
-    
-    if (index == -1) // means it is reserved word
+    KeywordInfo word = classifyWord(s + startIndex, length);
+    if (word.type == RESERVED)
     {
-      if (!name.compare("if"))
-        return onEndMatch(new ReservedWord(ReservedWord::ReservedType::IF));
-      if (!name.compare("elif"))
-        return onEndMatch(new ReservedWord(ReservedWord::ReservedType::ELIF));
-      if (!name.compare("else"))
-        return onEndMatch(new ReservedWord(ReservedWord::ReservedType::ELSE));
-      if (!name.compare("while"))
-        return onEndMatch(new ReservedWord(ReservedWord::ReservedType::WHILE));
-      if (!name.compare("for"))
-        return onEndMatch(new ReservedWord(ReservedWord::ReservedType::FOR));
-      if (!name.compare("begin"))
-      {
-        currentTable = new SymbolTable(currentTable);
-        return onEndMatch(new ReservedWord(ReservedWord::ReservedType::BEGIN));
-      }
-      if (!name.compare("end"))
-      {
-        currentTable = currentTable->getParent();
-        if (currentTable == nullptr)
-        {
-          state = LexerState::SYNTAX_ERROR;
-          return onEndMatch();
-        }
-        return onEndMatch(new ReservedWord(ReservedWord::ReservedType::END));
-      }
+      ReservedWord::ReservedType type = static_cast<ReservedWord::ReservedType>(word.value);
+      if (!onReservedWord(type))
+        return onEndMatch();
+      return onEndMatch(new (*region) ReservedWord(type));
     }
-    return onEndMatch(new Identifier(index, currentTable));
+
+    uint32_t symbol = putSymbol(s + startIndex, length, hash);
+    return onEndMatch(new (*region) Identifier(symbol, symbols.getScope()));
   }
   return onEndMatch();
 }
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdio>
+
+// a test program is a main that runs its checks and returns finishChecks(); each failed
+// check is printed where it happened, and any of them makes the program fail
+static int failedChecks = 0;
+
+inline bool checkResult(bool passed, const char *condition, const char *file, int line)
+{
+  if (!passed)
+  {
+    fprintf(stderr, "%s(%d): check failed: %s\n", file, line, condition);
+    failedChecks++;
+  }
+  return passed;
+}
+
+#define CHECK(condition) checkResult((condition), #condition, __FILE__, __LINE__)
+
+inline int finishChecks()
+{
+  if (failedChecks)
+    fprintf(stderr, "%d checks failed\n", failedChecks);
+  return failedChecks ? 1 : 0;
+}
@@ -0,0 +1,200 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <random>
+#include "Lexer.h"
+#include "Corpus.h"
+#include "Check.h"
+
+using namespace lex;
+
+// type, subtype, place and value of a token, equal for equal tokens of either engine
+static std::string describe(Token *token)
+{
+  int subtype = 0;
+  double value = 0;
+  switch (token->getType())
+  {
+  case INTEGER:
+    value = static_cast<Integer *>(token)->value;
+    break;
+  case lex::FLOAT:
+    subtype = static_cast<Float *>(token)->type;
+    value = static_cast<Float *>(token)->value;
+    break;
+  case LITERAL:
+    subtype = static_cast<Literal *>(token)->type;
+    break;
+  case lex::BOOL:
+    value = static_cast<Boolean *>(token)->value;
+    break;
+  case IDENTIFIER:
+    subtype = static_cast<Identifier *>(token)->scope;
+    value = static_cast<double>(static_cast<Identifier *>(token)->symbol);
+    break;
+  case RESERVED:
+    subtype = static_cast<ReservedWord *>(token)->type;
+    break;
+  case COMPARISON:
+    subtype = static_cast<Comparison *>(token)->type;
+    break;
+  case ARITHMETIC:
+    subtype = static_cast<Arithmetic *>(token)->type;
+    break;
+  case SHIFT:
+    subtype = static_cast<Shift *>(token)->type;
+    break;
+  case BITWISE_BINARY:
+    subtype = static_cast<BitwiseBinary *>(token)->type;
+    break;
+  case LOGIC_BINARY:
+    subtype = static_cast<LogicBinary *>(token)->type;
+    break;
+  default:
+    break;
+  }
+
+  char text[96];
+  sprintf(text, "%d.%d at %u+%u = %.17g", token->getType(), subtype, token->offset, token->length, value);
+  return text;
+}
+
+// both engines give the same tokens for text and stop in the same state; prints the first
+// difference
+static bool sameTokens(Lexer &table, Lexer &cascade, const std::string &text)
+{
+  while (true)
+  {
+    Token *expected = table.getNextToken();
+    Token *actual = cascade.getNextToken();
+    if (expected == nullptr || actual == nullptr)
+    {
+      if (expected == actual && table.getState() == cascade.getState())
+        return true;
+      fprintf(stderr, "[%s]: table %s in state %d, cascade %s in state %d\n", text.c_str(),
+        expected ? describe(expected).c_str() : "stops", table.getState(), actual ? describe(actual).c_str() : "stops", cascade.getState());
+      return false;
+    }
+    if (describe(expected) != describe(actual))
+    {
+      fprintf(stderr, "[%.60s]: table %s, cascade %s\n", text.c_str(), describe(expected).c_str(), describe(actual).c_str());
+      return false;
+    }
+  }
+}
+
+static bool sameTokens(const std::string &text)
+{
+  Lexer table(text.c_str(), text.size(), TABLE_DRIVEN);
+  Lexer cascade(text.c_str(), text.size(), MATCHER_CASCADE);
+  return sameTokens(table, cascade, text);
+}
+
+static void checkCorpora()
+{
+  for (int mix = 0; mix < CORPUS_MIX_COUNT; mix++)
+  {
+    std::string text = generateCorpus(static_cast<CorpusMix>(mix), 256 * 1024, 3);
+    CHECK(sameTokens(text));
+  }
+}
+
+// brackets and operators written without blanks between them, as in most real code
+static const char *const unspaced[] =
+{
+  "x = ((1 + 2))",
+  "x = f(g(y))",
+  "x = -(a)",
+  "x = a*(b+c)",
+  "if !(a) x = 1",
+  "x = a[i][j]+f()*~(b)",
+  "x = (a)"
+};
+
+static void checkUnspaced()
+{
+  for (size_t i = 0; i < sizeof(unspaced) / sizeof(unspaced[0]); i++)
+  {
+    std::string text = unspaced[i];
+    Lexer lexer(text.c_str(), text.size());
+    TokenStream stream;
+    CHECK(lexer.tokenize(stream));
+    CHECK(sameTokens(text));
+  }
+}
+
+// short runs of valid and broken tokens glued together, so both engines also meet every error
+static void checkRandomText()
+{
+  static const char *const pieces[] =
+  {
+    " ", "\n", "\t", "a", "x1", "_y", "\xC3\xA9t\xC3\xA9", "true", "false", "begin", "end", "int", "if", "elif", "while",
+    "0", "1", "12", "017", "0x1F", "0o17", "0q123", "0b101", "0x", "0q4", "0b2", "99999999999", "0x1FFFFFFFF",
+    "1.5", "2.5e3", "1.5f", "3.0d", "1.", "1e", "1e+", "1.5e99999",
+    "\"s\"", "\"e\\n\"", "\"open", "// c\n", "/* c */",
+    "+", "-", "*", "/", "%", "<", ">", "<=", ">=", "==", "!=", "<<", ">>", "&", "|", "^", "~", "&&", "||", "!", "=",
+    "(", ")", "[", "]", ";", ",", "=>", "!!", "a.b", "@", "\xFF", "\xE2\x82"
+  };
+  const size_t PIECE_COUNT = sizeof(pieces) / sizeof(pieces[0]);
+
+  std::mt19937 random(1);
+  size_t failures = 0;
+  for (int i = 0; i < 50000 && failures < 10; i++)
+  {
+    std::string text;
+    size_t count = 1 + random() % 12;
+    for (size_t j = 0; j < count; j++)
+    {
+      text += pieces[random() % PIECE_COUNT];
+      if (random() % 2)
+        text += ' ';
+    }
+    if (!CHECK(sameTokens(text)))
+      failures++;
+  }
+}
+
+// the symbols of a reused lexer, names included, are those of a new one
+static bool sameSymbols(const ScopedSymbolTable &expected, const ScopedSymbolTable &actual)
+{
+  if (expected.size() != actual.size())
+    return false;
+  for (uint32_t i = 0; i < expected.size(); i++)
+  {
+    if (strcmp(expected.getName(i), actual.getName(i)) || expected.getScope(i) != actual.getScope(i))
+      return false;
+  }
+  return true;
+}
+
+// the same two lexers from unit to unit, with their tokens in one region reset in between
+static void checkReusedLexers()
+{
+  Arena region;
+  Lexer table(&region);
+  Lexer cascade(&region);
+  cascade.setEngine(MATCHER_CASCADE);
+  for (int unit = 0; unit < 3 * CORPUS_MIX_COUNT; unit++)
+  {
+    std::string text = generateCorpus(static_cast<CorpusMix>(unit % CORPUS_MIX_COUNT), 64 * 1024, unit);
+    table.setText(text.c_str(), text.size());
+    cascade.setText(text.c_str(), text.size());
+    CHECK(sameTokens(table, cascade, text));
+
+    Lexer fresh(text.c_str(), text.size());
+    TokenStream stream;
+    fresh.tokenize(stream);
+    CHECK(sameSymbols(fresh.getSymbols(), table.getSymbols()));
+    CHECK(sameSymbols(fresh.getSymbols(), cascade.getSymbols()));
+    region.reset();
+  }
+}
+
+int main()
+{
+  checkCorpora();
+  checkReusedLexers();
+  checkUnspaced();
+  checkRandomText();
+  return finishChecks();
+}
@@ -0,0 +1,140 @@
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <random>
+#include "Numbers.h"
+#include "Check.h"
+
+using namespace lex;
+
+// bit patterns that no conversion gives, standing for NUMBER_OVERFLOW
+const uint64_t DOUBLE_OVERFLOW = ~0ULL;
+const uint32_t FLOAT_OVERFLOW = ~0u;
+
+struct FloatCase
+{
+  const char *text;
+  uint64_t doubleBits;
+  uint32_t floatBits;
+};
+
+// correctly rounded results, ties to even: the limits of both types, subnormals, ties and
+// the values just past them, and digits beyond what Eisel-Lemire can decide
+static const FloatCase cases[] =
+{
+  { "0.1", 0x3FB999999999999AULL, 0x3DCCCCCDu },
+  { "1.5", 0x3FF8000000000000ULL, 0x3FC00000u },
+  { "123.456", 0x405EDD2F1A9FBE77ULL, 0x42F6E979u },
+  { "1e23", 0x44B52D02C7E14AF6ULL, 0x65A96816u },
+  { "2.2250738585072011e-308", 0x000FFFFFFFFFFFFFULL, 0x00000000u },
+  { "2.2250738585072014e-308", 0x0010000000000000ULL, 0x00000000u },
+  { "4.9406564584124654e-324", 0x0000000000000001ULL, 0x00000000u },
+  { "2.4703282292062327e-324", 0x0000000000000000ULL, 0x00000000u },
+  { "2.4703282292062328e-324", 0x0000000000000001ULL, 0x00000000u },
+  { "1.7976931348623157e308", 0x7FEFFFFFFFFFFFFFULL, FLOAT_OVERFLOW },
+  { "1.7976931348623159e308", DOUBLE_OVERFLOW, FLOAT_OVERFLOW },
+  { "9007199254740993", 0x4340000000000000ULL, 0x5A000000u },
+  { "9007199254740993.00000000001", 0x4340000000000001ULL, 0x5A000000u },
+  { "8.98846567431158e307", 0x7FE0000000000000ULL, FLOAT_OVERFLOW },
+  { "3.4028235e38", 0x47EFFFFFE54DAFF8ULL, 0x7F7FFFFFu },
+  { "3.4028236e38", 0x47EFFFFFF514A7BCULL, FLOAT_OVERFLOW },
+  { "1.4e-45", 0x369FF868BF4D956AULL, 0x00000001u },
+  { "7e-46", 0x368FF868BF4D956AULL, 0x00000000u },
+  { "7.1e-46", 0x369036AA2680F22CULL, 0x00000001u },
+  { "1.17549435e-38", 0x380FFFFFFF9FDBA8ULL, 0x00800000u },
+  { "16777217", 0x4170000010000000ULL, 0x4B800000u },
+  { "16777219", 0x4170000030000000ULL, 0x4B800002u },
+  { "1.000000059604644775390625", 0x3FF0000010000000ULL, 0x3F800000u },
+  { "1.000000059604644775390626", 0x3FF0000010000000ULL, 0x3F800001u },
+  { "0.000001", 0x3EB0C6F7A0B5ED8DULL, 0x358637BDu },
+  { "1e-400", 0x0000000000000000ULL, 0x00000000u },
+  { "1e400", DOUBLE_OVERFLOW, FLOAT_OVERFLOW },
+  { "123456789012345678901234567890", 0x45F8EE90FF6C373EULL, 0x6FC77488u },
+  { "0.0", 0x0000000000000000ULL, 0x00000000u },
+  { "0e5", 0x0000000000000000ULL, 0x00000000u },
+  { "1e0", 0x3FF0000000000000ULL, 0x3F800000u },
+  { "7.", 0x401C000000000000ULL, 0x40E00000u },
+  { "4.35679e-5", 0x3F06D795A52EA853ULL, 0x3836BCADu },
+  // exactly half the smallest subnormal double and a little more, written out in full
+  { "2.4703282292062327208828439643411068618252990130716238221279284125033775363510437593264991818081"
+    "799618989828234772285886546332835517796989819938739800539093906315035659515570226392290858392449"
+    "105184435931802849936536152500319370457678249219365623669863658480757001585769269903706311928279"
+    "558551332927834338409351978015531246597263579574622766465272827220056374006485499977096599470454"
+    "020828166226237857393450736339007967761930577506740176324673600968951340535537458516661134223766"
+    "678604162159680461914467291840300530057530849048765391711386591646239524912623653881879636239373"
+    "280423891018672348497668235089863388587925628302755995657524455507255189313690836254779186948667"
+    "994968324049705821028513185451396213837722826145437693412532098591327667236328125e-324", 0x0000000000000000ULL, 0x00000000u },
+  { "2.4703282292062327208828439643411068618252990130716238221279284125033775363510437593264991818081"
+    "799618989828234772285886546332835517796989819938739800539093906315035659515570226392290858392449"
+    "1051844359318028499365361525003193704576782492193656236698636584807570426e-324", 0x0000000000000001ULL, 0x00000000u },
+};
+
+static uint64_t bitsOf(double value)
+{
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static uint32_t bitsOf(float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static bool parsesTo(const char *text, uint64_t expected)
+{
+  double value;
+  NumberStatus status = parseDouble(text, strlen(text), value);
+  bool passed = (expected == DOUBLE_OVERFLOW) ? status == NUMBER_OVERFLOW : status == NUMBER_OK && bitsOf(value) == expected;
+  if (!passed)
+    fprintf(stderr, "double %s: status %d, bits %016llx\n", text, status, static_cast<unsigned long long>(bitsOf(value)));
+  return passed;
+}
+
+static bool parsesTo(const char *text, uint32_t expected)
+{
+  float value;
+  NumberStatus status = parseFloat(text, strlen(text), value);
+  bool passed = (expected == FLOAT_OVERFLOW) ? status == NUMBER_OVERFLOW : status == NUMBER_OK && bitsOf(value) == expected;
+  if (!passed)
+    fprintf(stderr, "float %s: status %d, bits %08x\n", text, status, bitsOf(value));
+  return passed;
+}
+
+// the shortest digits printf guarantees to identify a value parse back to that very value
+static void checkRoundTrips()
+{
+  std::mt19937_64 random(7);
+  char text[64];
+  size_t failures = 0;
+  for (int i = 0; i < 200000 && failures < 10; i++)
+  {
+    uint64_t doubleBits = random() % 0x7FF0000000000000ULL; // positive and finite
+    double doubleValue;
+    memcpy(&doubleValue, &doubleBits, sizeof(doubleValue));
+    sprintf(text, "%.17g", doubleValue);
+    if (!CHECK(parsesTo(text, doubleBits)))
+      failures++;
+
+    uint32_t floatBits = static_cast<uint32_t>(random() % 0x7F800000u);
+    float floatValue;
+    memcpy(&floatValue, &floatBits, sizeof(floatValue));
+    sprintf(text, "%.9g", floatValue);
+    if (!CHECK(parsesTo(text, floatBits)))
+      failures++;
+  }
+}
+
+int main()
+{
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+  {
+    CHECK(parsesTo(cases[i].text, cases[i].doubleBits));
+    CHECK(parsesTo(cases[i].text, cases[i].floatBits));
+  }
+  checkRoundTrips();
+  return finishChecks();
+}
@@ -0,0 +1,167 @@
+#include <climits>
+#include <string>
+#include "Lexer.h"
+#include "Parser.h"
+#include "ConstantFolder.h"
+#include "Check.h"
+
+using namespace lex;
+
+struct FoldResult
+{
+  FoldResult() : status(FOLD_SKIPPED), errorOffset(0) {}
+
+  FoldStatus status;   // FOLD_OK when the whole expression became one value
+  ConstantValue value;
+  size_t errorOffset;  // in the expression, of the operator that divides by zero
+};
+
+// folds the initializer of "int x = expression" and tells what became of it
+static FoldResult fold(const std::string &expression)
+{
+  static const std::string DECLARATION = "int x = ";
+  std::string text = DECLARATION + expression + "\n";
+  FoldResult result;
+
+  Lexer lexer(text.c_str(), text.size());
+  TokenStream stream;
+  if (!CHECK(lexer.tokenize(stream)))
+    return result;
+  TokenView tokens = stream.view();
+  Syntax tree;
+  Parser parser(tokens);
+  if (!CHECK(parser.parse(tree)))
+    return result;
+
+  ConstantFolder folder(tokens);
+  if (!folder.fold(tree))
+  {
+    result.status = FOLD_DIVISION_BY_ZERO;
+    result.errorOffset = tokens[folder.getErrorToken()].getOffset() - DECLARATION.size();
+    return result;
+  }
+
+  NodeIndex declaration = tree.getList(tree[tree.getRoot()].child[0])[0];
+  NodeIndex initializer = tree[declaration].child[1];
+  if (tree.getKind(initializer) == NODE_VALUE)
+  {
+    result.status = FOLD_OK;
+    result.value = tree.getValue(initializer);
+  }
+  return result;
+}
+
+static bool foldsToInt(const char *expression, int expected)
+{
+  FoldResult result = fold(expression);
+  return result.status == FOLD_OK && result.value.type == INTEGER && result.value.value.intValue == expected;
+}
+
+static bool foldsToFloat(const char *expression, float expected)
+{
+  FoldResult result = fold(expression);
+  return result.status == FOLD_OK && result.value.type == lex::FLOAT && result.value.subtype == Float::SINGLE
+    && result.value.value.floatValue == expected;
+}
+
+static bool foldsToDouble(const char *expression, double expected)
+{
+  FoldResult result = fold(expression);
+  return result.status == FOLD_OK && result.value.type == lex::FLOAT && result.value.subtype == Float::DOUBLE
+    && result.value.value.doubleValue == expected;
+}
+
+static bool foldsToBool(const char *expression, bool expected)
+{
+  FoldResult result = fold(expression);
+  return result.status == FOLD_OK && result.value.type == lex::BOOL && result.value.value.boolValue == expected;
+}
+
+static bool staysUnfolded(const char *expression)
+{
+  return fold(expression).status == FOLD_SKIPPED;
+}
+
+// a whole text, which has to lex, parse and fold
+static bool foldsText(const std::string &text)
+{
+  Lexer lexer(text.c_str(), text.size());
+  TokenStream stream;
+  if (!lexer.tokenize(stream))
+    return false;
+  TokenView tokens = stream.view();
+  Syntax tree;
+  Parser parser(tokens);
+  if (!parser.parse(tree))
+    return false;
+  return ConstantFolder(tokens).fold(tree);
+}
+
+static bool dividesByZeroAt(const char *expression, size_t offset)
+{
+  FoldResult result = fold(expression);
+  return result.status == FOLD_DIVISION_BY_ZERO && result.errorOffset == offset;
+}
+
+int main()
+{
+  CHECK(foldsToInt("1 + 2 * 3", 7));
+  CHECK(foldsToInt("(1 + 2) * 3", 9));
+  CHECK(foldsToInt("-7 / 2", -3));
+  CHECK(foldsToInt("-7 % 3", -1));
+  CHECK(foldsToInt("0x10 + 0b11", 19));
+  CHECK(foldsToInt("5 & 3 | 8 ^ 1", 9));
+  CHECK(foldsToInt("~0", -1));
+
+  // integers wrap around in 32 bits, INT_MIN / -1 included
+  CHECK(foldsToInt("2147483647 + 1", INT_MIN));
+  CHECK(foldsToInt("-2147483647 - 1", INT_MIN));
+  CHECK(foldsToInt("(-2147483647 - 1) / -1", INT_MIN));
+  CHECK(foldsToInt("(-2147483647 - 1) % -1", 0));
+  CHECK(foldsToInt("65536 * 65536", 0));
+
+  // shifts by 0 to 31 are folded, others are left for the program to do
+  CHECK(foldsToInt("1 << 31", INT_MIN));
+  CHECK(foldsToInt("1 << 0", 1));
+  CHECK(foldsToInt("-8 >> 1", -4));
+  CHECK(foldsToInt("0x80000000 >> 31", -1));
+  CHECK(staysUnfolded("1 << 32"));
+  CHECK(staysUnfolded("1 >> -1"));
+
+  // the wider type of the two operands
+  CHECK(foldsToFloat("0q1220123 * 454.6", 3038091.75f));
+  CHECK(foldsToFloat("1 / 4.0", 0.25f));
+  CHECK(foldsToDouble("1.0f + 2.0d", 3.0));
+  CHECK(foldsToDouble("1 / 3.0d", 1 / 3.0));
+  CHECK(staysUnfolded("1.5 % 2"));
+
+  CHECK(foldsToBool("1 < 2.5", true));
+  CHECK(foldsToBool("3 == 3.0", true));
+  CHECK(foldsToBool("true && !false", true));
+  CHECK(foldsToBool("1 == 1 == true", true));
+  CHECK(staysUnfolded("true + 1"));
+  CHECK(staysUnfolded("true < false"));
+  CHECK(staysUnfolded("\"a\" == 1"));
+  CHECK(staysUnfolded("y + 1 * 2"));
+
+  // division by a constant zero is an error at its operator, whatever is divided
+  CHECK(dividesByZeroAt("7 / 0", 2));
+  CHECK(dividesByZeroAt("7 % 0", 2));
+  CHECK(dividesByZeroAt("1.5 / 0", 4));
+  CHECK(dividesByZeroAt("1 / 0.0d", 2));
+  CHECK(dividesByZeroAt("1 + 10 / (2 - 2)", 7));
+  CHECK(dividesByZeroAt("y / (3 - 3)", 2));
+  CHECK(staysUnfolded("0 / y"));
+
+  // brackets and operators without blanks between them
+  CHECK(foldsToInt("((1 + 2))", 3));
+  CHECK(foldsToInt("-(2)", -2));
+  CHECK(foldsToInt("2*(3+4)", 14));
+  CHECK(foldsToBool("!(1 < 2)", false));
+  CHECK(foldsText("x = ((1 + 2))"));
+  CHECK(foldsText("x = f(g(y))"));
+  CHECK(foldsText("x = -(a)"));
+  CHECK(foldsText("x = a*(b+c)"));
+  CHECK(foldsText("if !(a) x = 1"));
+  return finishChecks();
+}
@@ -0,0 +1,160 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+#include "IncrementalLexer.h"
+#include "Corpus.h"
+#include "Check.h"
+
+using namespace lex;
+
+// the edited lexer holds what one made from scratch holds for the same text
+static bool sameAsFresh(IncrementalLexer &edited, const std::string &text)
+{
+  IncrementalLexer fresh;
+  fresh.setText(text.c_str(), text.size());
+  if (edited.size() != fresh.size() || edited.getState() != fresh.getState())
+  {
+    fprintf(stderr, "%u lexemes in state %d instead of %u in state %d\n", unsigned(edited.size()), edited.getState(),
+      unsigned(fresh.size()), fresh.getState());
+    return false;
+  }
+  for (size_t i = 0; i < fresh.size(); i++)
+  {
+    Lexeme actual = edited.getLexeme(i);
+    Lexeme expected = fresh.getLexeme(i);
+    if (actual.type != expected.type || actual.subtype != expected.subtype || actual.offset != expected.offset
+      || actual.length != expected.length || edited.getDepth(i) != fresh.getDepth(i)
+      || (expected.type == IDENTIFIER && strcmp(edited.getName(actual), fresh.getName(expected)))
+      || (expected.type == INTEGER && actual.intValue != expected.intValue))
+    {
+      fprintf(stderr, "lexeme %u at offset %u differs\n", unsigned(i), unsigned(expected.offset));
+      return false;
+    }
+  }
+  return true;
+}
+
+// and what Lexer::tokenize makes of it
+static bool sameAsLexer(IncrementalLexer &edited, const std::string &text)
+{
+  Lexer lexer(text.c_str(), text.size());
+  TokenStream stream;
+  bool lexed = lexer.tokenize(stream);
+  TokenView tokens = stream.view();
+  if (tokens.size() != edited.size() || lexed != (edited.getState() == FINISHED))
+    return false;
+  for (size_t i = 0; i < tokens.size(); i++)
+  {
+    if (tokens[i].getType() != edited.getLexeme(i).type || tokens[i].getOffset() != edited.getLexeme(i).offset)
+      return false;
+  }
+  return true;
+}
+
+struct Edit
+{
+  size_t offset;
+  size_t removed;
+  std::string inserted;
+};
+
+// edits close to each other, often taken back again, so that errors come and go and the
+// lexemes parked behind them are lined up with again. Half of the edits are made where the
+// visible lexemes end, which is where lexing resumes after an error
+static void fuzzEdits(uint32_t seed, int editCount)
+{
+  static const char *const pieces[] =
+  {
+    " ", "\n", "a", "1", "e", "x", "0x", "+", "/", "*", "true", "=", ";", "beg", "in", "begin ", "end ", "begin", "end",
+    "/*", "*/", "//", "\"", ".", "\\", "\xC3\xA9"
+  };
+  const size_t PIECE_COUNT = sizeof(pieces) / sizeof(pieces[0]);
+
+  std::mt19937 random(seed);
+  std::string text = generateCorpus(MIX_BLEND, 4096, seed);
+  IncrementalLexer edited;
+  edited.setText(text.c_str(), text.size());
+
+  std::vector<Edit> undo;
+  size_t focus = random() % text.size();
+  for (int i = 0; i < editCount; i++)
+  {
+    Edit edit;
+    if (!undo.empty() && (undo.size() >= 4 || random() % 3 == 0))
+    {
+      edit = undo.back();
+      undo.pop_back();
+    }
+    else
+    {
+      if (random() % 20 == 0)
+        focus = random() % (text.size() + 1);
+      size_t visibleEnd = 0;
+      if (edited.size())
+      {
+        Lexeme last = edited.getLexeme(edited.size() - 1);
+        visibleEnd = last.offset + last.length;
+      }
+      size_t near = (random() % 2) ? visibleEnd : focus;
+      edit.offset = std::min(text.size(), near + random() % 16);
+      edit.removed = (random() % 3 == 0) ? random() % std::min<size_t>(6, text.size() - edit.offset + 1) : 0;
+      edit.inserted = (random() % 4 == 0) ? "" : pieces[random() % PIECE_COUNT];
+
+      Edit inverse = { edit.offset, edit.inserted.size(), text.substr(edit.offset, edit.removed) };
+      undo.push_back(inverse);
+    }
+
+    // an edit that splits a UTF-8 sequence is refused, and so is taking it back
+    if (!edited.edit(edit.offset, edit.removed, edit.inserted.c_str(), edit.inserted.size()))
+    {
+      undo.clear();
+      continue;
+    }
+    text.replace(edit.offset, edit.removed, edit.inserted);
+
+    if (!CHECK(sameAsFresh(edited, text)))
+    {
+      fprintf(stderr, "seed %u, edit %d\n", seed, i);
+      return;
+    }
+    if (i % 64 == 0)
+      CHECK(sameAsLexer(edited, text));
+  }
+}
+
+// taking away a begin far from the end it leaves unmatched, in a text of many blocks, and
+// putting it back again
+static void checkUnmatchedEnd()
+{
+  std::string text = "begin ";
+  for (int i = 0; i < 20000; i++)
+    text += (i % 3) ? "begin x = 1 end " : "begin begin y end end ";
+  text += "end ";
+
+  IncrementalLexer edited;
+  edited.setText(text.c_str(), text.size());
+  const size_t offsets[] = { 0, 6, text.size() / 2 };
+  for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++)
+  {
+    size_t offset = text.find("begin", offsets[i]);
+    CHECK(edited.edit(offset, 5, "", 0));
+    text.erase(offset, 5);
+    CHECK(edited.getState() == SYNTAX_ERROR);
+    CHECK(sameAsFresh(edited, text));
+
+    CHECK(edited.edit(offset, 0, "begin", 5));
+    text.insert(offset, "begin");
+    CHECK(edited.getState() == FINISHED);
+    CHECK(sameAsFresh(edited, text));
+  }
+}
+
+int main()
+{
+  checkUnmatchedEnd();
+  for (uint32_t seed = 1; seed <= 20; seed++)
+    fuzzEdits(seed, 2000);
+  return finishChecks();
+}
@@ -0,0 +1,90 @@
+#include <cstring>
+#include <string>
+#include "Keywords.h"
+#include "Check.h"
+
+using namespace lex;
+
+struct Keyword
+{
+  const char *text;
+  TokenType type;
+  int value;
+};
+
+// every word the language reserves, with what classifyWord has to make of it
+static const Keyword keywords[] =
+{
+  { "if", RESERVED, ReservedWord::IF },
+  { "elif", RESERVED, ReservedWord::ELIF },
+  { "else", RESERVED, ReservedWord::ELSE },
+  { "while", RESERVED, ReservedWord::WHILE },
+  { "for", RESERVED, ReservedWord::FOR },
+  { "begin", RESERVED, ReservedWord::BEGIN },
+  { "end", RESERVED, ReservedWord::END },
+  { "true", lex::BOOL, true },
+  { "false", lex::BOOL, false }
+};
+const size_t KEYWORD_COUNT = sizeof(keywords) / sizeof(keywords[0]);
+
+static bool isKeyword(const char *word, const Keyword &expected)
+{
+  KeywordInfo info = classifyWord(word, strlen(word));
+  return info.type == expected.type && info.value == expected.value;
+}
+
+static bool isName(const std::string &word)
+{
+  return classifyWord(word.c_str(), word.size()).type == IDENTIFIER;
+}
+
+int main()
+{
+  // the table is laid out by keywordSlot: each keyword sits in its own slot, the one the
+  // hash gives it, and every other slot is empty
+  size_t used = 0;
+  for (size_t slot = 0; slot < KEYWORD_TABLE_SIZE; slot++)
+  {
+    const KeywordEntry &e = keywordTable[slot];
+    if (e.length == 0)
+      continue;
+    used++;
+    CHECK(strlen(e.text) == e.length);
+    CHECK(keywordSlot(e.text, e.length) == slot);
+  }
+  CHECK(used == KEYWORD_COUNT);
+
+  for (size_t i = 0; i < KEYWORD_COUNT; i++)
+  {
+    const char *text = keywords[i].text;
+    size_t length = strlen(text);
+    CHECK(length >= KEYWORD_MIN_LENGTH && length <= KEYWORD_MAX_LENGTH);
+    CHECK(isKeyword(text, keywords[i]));
+
+    // near misses: one letter more, one less, one changed, another case
+    std::string word = text;
+    CHECK(isName(word + "s"));
+    CHECK(isName("_" + word));
+    CHECK(isName(word.substr(0, length - 1)));
+    CHECK(isName(word.substr(1)));
+    for (size_t j = 0; j < length; j++)
+    {
+      std::string changed = word;
+      changed[j] = (changed[j] == 'z') ? 'y' : changed[j] + 1;
+      CHECK(isName(changed));
+      changed[j] = word[j] - 'a' + 'A';
+      CHECK(isName(changed));
+    }
+  }
+
+  // names with the length, first and last letter of a keyword land in its slot
+  static const char *const collisions[] = { "iF", "eaif", "exse", "wxxxe", "fxr", "bxxxn", "ebd", "tlue", "fxxxe" };
+  for (size_t i = 0; i < sizeof(collisions) / sizeof(collisions[0]); i++)
+  {
+    CHECK(keywordSlot(collisions[i], strlen(collisions[i])) == keywordSlot(keywords[i].text, strlen(keywords[i].text)));
+    CHECK(isName(collisions[i]));
+  }
+  CHECK(isName("int"));
+  CHECK(isName("x"));
+  return finishChecks();
+}
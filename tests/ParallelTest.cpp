@@ -0,0 +1,118 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "Lexer.h"
+#include "ParallelLexer.h"
+#include "Corpus.h"
+#include "Check.h"
+
+using namespace lex;
+
+static bool sameStreams(const TokenView &expected, const TokenView &actual)
+{
+  if (expected.size() != actual.size())
+  {
+    fprintf(stderr, "%u tokens instead of %u\n", unsigned(actual.size()), unsigned(expected.size()));
+    return false;
+  }
+  for (size_t i = 0; i < expected.size(); i++)
+  {
+    if (expected.types[i] != actual.types[i] || expected.subtypes[i] != actual.subtypes[i] || expected.offsets[i] != actual.offsets[i]
+      || expected.lengths[i] != actual.lengths[i] || memcmp(&expected.values[i], &actual.values[i], sizeof(TokenValue)))
+    {
+      fprintf(stderr, "token %u at offset %u differs\n", unsigned(i), unsigned(expected.offsets[i]));
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool sameSymbols(const ScopedSymbolTable &expected, const ScopedSymbolTable &actual)
+{
+  if (expected.size() != actual.size())
+    return false;
+  for (uint32_t i = 0; i < expected.size(); i++)
+  {
+    if (strcmp(expected.getName(i), actual.getName(i)) || expected.getScope(i) != actual.getScope(i))
+      return false;
+  }
+  return true;
+}
+
+// the parallel lexer gives the stream, symbols and state of the sequential one, however the
+// text is split
+static void checkSameAsLexer(const std::string &text, size_t threadCount)
+{
+  Lexer lexer(text.c_str(), text.size());
+  TokenStream expected;
+  bool lexed = lexer.tokenize(expected);
+
+  ParallelLexer parallel(threadCount);
+  parallel.setSource(text.c_str(), text.size());
+  TokenStream actual;
+  CHECK(parallel.tokenize(actual) == lexed);
+  CHECK(parallel.getState() == lexer.getState());
+  if (!lexed)
+    CHECK(parallel.getOffset() == lexer.getOffset());
+  CHECK(sameStreams(expected.view(), actual.view()));
+  CHECK(sameSymbols(lexer.getSymbols(), parallel.getSymbols()));
+}
+
+// one parallel lexer for text after text gives what a new one gives for each
+static void checkReused()
+{
+  static const char *const texts[] =
+  {
+    "begin x = 1 ",
+    "y = 2 end ",
+    "begin a = 1 begin b = a end ",
+    "c = b ",
+    "end "
+  };
+  ParallelLexer reused(2);
+  for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); i++)
+  {
+    std::string text = texts[i];
+    Lexer lexer(text.c_str(), text.size());
+    TokenStream expected;
+    bool lexed = lexer.tokenize(expected);
+
+    reused.setSource(text.c_str(), text.size());
+    TokenStream actual;
+    CHECK(reused.tokenize(actual) == lexed);
+    CHECK(reused.getState() == lexer.getState());
+    CHECK(lexed || reused.getOffset() == lexer.getOffset());
+    CHECK(sameStreams(expected.view(), actual.view()));
+    CHECK(sameSymbols(lexer.getSymbols(), reused.getSymbols()));
+  }
+}
+
+int main()
+{
+  checkReused();
+  // several chunks per thread at the smallest chunk size
+  std::string blend = generateCorpus(MIX_BLEND, 4 * 1024 * 1024, 5);
+  for (size_t threads = 1; threads <= 4; threads++)
+    checkSameAsLexer(blend, threads);
+
+  for (int mix = 0; mix < MIX_BLEND; mix++)
+    checkSameAsLexer(generateCorpus(static_cast<CorpusMix>(mix), 2 * 1024 * 1024, 7), 4);
+
+  // errors stop both at the same offset, wherever they are in the text
+  static const char *const errors[] =
+  {
+    "begin x = 1 end end y = 2 ",
+    "x = 99999999999999999999 ",
+    "x = 1 @ y ",
+    "x = \"abc",
+    "x = 1 /* open",
+    "x = \xC3 y ",
+    "end "
+  };
+  for (size_t i = 0; i < sizeof(errors) / sizeof(errors[0]); i++)
+  {
+    checkSameAsLexer(errors[i], 2);
+    checkSameAsLexer(blend + errors[i] + blend, 4); // past the first chunk
+  }
+  return finishChecks();
+}
@@ -0,0 +1,92 @@
+#include <string>
+#include "Lexer.h"
+#include "Parser.h"
+#include "Check.h"
+
+using namespace lex;
+
+// the expressions of a tree written out with every operator bracketed, as in (+ a (* b c)),
+// f(a b) for a call and a[i] for an index; statements are left out but for their expressions
+static std::string show(const Syntax &tree, NodeIndex node, const TokenView &tokens, const std::string &text)
+{
+  const SyntaxNode &n = tree[node];
+  TokenRef token = tokens[n.token];
+  std::string spelling = text.substr(token.getOffset(), token.getLength());
+  switch (tree.getKind(node))
+  {
+  case NODE_NAME:
+  case NODE_CONSTANT:
+    return spelling;
+  case NODE_UNARY:
+    return "(" + spelling + " " + show(tree, n.child[0], tokens, text) + ")";
+  case NODE_BINARY:
+    return "(" + spelling + " " + show(tree, n.child[0], tokens, text) + " " + show(tree, n.child[1], tokens, text) + ")";
+  case NODE_INDEX:
+    return show(tree, n.child[0], tokens, text) + "[" + show(tree, n.child[1], tokens, text) + "]";
+  case NODE_CALL:
+    {
+      std::string call = show(tree, n.child[0], tokens, text) + "(";
+      for (NodeIndex i = 0; i < n.child[2]; i++)
+        call += (i ? " " : "") + show(tree, tree.getList(n.child[1])[i], tokens, text);
+      return call + ")";
+    }
+  case NODE_ASSIGNMENT:
+    return show(tree, n.child[0], tokens, text) + " = " + show(tree, n.child[1], tokens, text);
+  case NODE_IF:
+    return "if " + show(tree, n.child[0], tokens, text) + " " + show(tree, n.child[1], tokens, text);
+  default:
+    return "?";
+  }
+}
+
+// the one statement of text, shown as above, or the error the parser stopped on
+static std::string parse(const std::string &text)
+{
+  Lexer lexer(text.c_str(), text.size());
+  TokenStream stream;
+  if (!lexer.tokenize(stream))
+    return "lexing stopped";
+  TokenView tokens = stream.view();
+  Syntax tree;
+  Parser parser(tokens);
+  if (!parser.parse(tree))
+    return parser.getError();
+
+  const SyntaxNode &program = tree[tree.getRoot()];
+  if (program.child[1] != 1)
+    return "not one statement";
+  return show(tree, tree.getList(program.child[0])[0], tokens, text);
+}
+
+static std::string repeat(const char *piece, unsigned count)
+{
+  std::string text;
+  for (unsigned i = 0; i < count; i++)
+    text += piece;
+  return text;
+}
+
+int main()
+{
+  // brackets, calls and unary operators written without blanks, as in most real code
+  CHECK(parse("x = ((1 + 2))") == "x = (+ 1 2)");
+  CHECK(parse("x = f(g(y))") == "x = f(g(y))");
+  CHECK(parse("x = -(a)") == "x = (- a)");
+  CHECK(parse("x = a*(b+c)") == "x = (* a (+ b c))");
+  CHECK(parse("if !(a) x = 1") == "if (! a) x = 1");
+  CHECK(parse("x = f(a,b)[i][j+1]") == "x = f(a b)[i][(+ j 1)]");
+  CHECK(parse("x = -~!(a)") == "x = (- (~ (! a)))");
+  CHECK(parse("x = f()") == "x = f()");
+
+  // nesting up to the limit parses, past it the parser stops with an error rather than
+  // running out of stack; each bracket is one level, the assignment's value another
+  unsigned depth = Parser::MAX_NESTING - 2;
+  CHECK(parse("x = " + repeat("(", depth) + "1" + repeat(")", depth)) == "x = 1");
+  CHECK(parse("x = " + repeat("(", depth + 1) + "1" + repeat(")", depth + 1)) == "nested too deeply");
+  CHECK(parse("x = " + repeat("(", 100000) + "1" + repeat(")", 100000)) == "nested too deeply");
+  CHECK(parse("x = " + repeat("-", 100000) + "1") == "nested too deeply");
+  CHECK(parse("x = " + repeat("f(", 100000) + "1" + repeat(")", 100000)) == "nested too deeply");
+  CHECK(parse(repeat("begin ", 100000) + repeat("end ", 100000)) == "nested too deeply");
+  CHECK(parse("if a x = 1" + repeat(" elif a x = 1", 100000)) == "nested too deeply");
+  return finishChecks();
+}
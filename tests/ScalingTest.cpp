@@ -0,0 +1,83 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "Lexer.h"
+#include "Check.h"
+
+using namespace lex;
+
+// statements of long names and a few operators, all on one line as minified input would be
+static std::string makeLongLine(size_t statements)
+{
+  std::string text;
+  for (size_t i = 0; i < statements; i++)
+  {
+    text += "variable_with_a_long_name_" + std::to_string(i % 1000) + " = other_name_" + std::to_string(i % 997);
+    text += " * " + std::to_string(i) + " + x; ";
+  }
+  return text;
+}
+
+// the automaton is run through batches, so that only lexing is timed and not the growth of
+// the region tokens are made in; the cascade has no other way than one token at a time
+static size_t lexAll(const std::string &text, LexerEngine engine)
+{
+  Lexer lexer(text.c_str(), text.size(), engine);
+  size_t total = 0;
+  if (engine == TABLE_DRIVEN)
+  {
+    std::vector<Lexeme> batch(256);
+    size_t count;
+    while (lexer.getNextTokens(&batch[0], batch.size(), count) == BATCH_OK)
+      total += count;
+    total += count;
+  }
+  else
+  {
+    while (lexer.getNextToken() != nullptr)
+      total++;
+  }
+  CHECK(lexer.getState() == FINISHED);
+  return total;
+}
+
+// best of a few runs, the others only warm up caches
+static double timeLexing(const std::string &text, LexerEngine engine, size_t expectedTokens)
+{
+  double best = 0;
+  for (int run = 0; run < 3; run++)
+  {
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    size_t count = lexAll(text, engine);
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    CHECK(count == expectedTokens);
+    if (run == 0 || seconds < best)
+      best = seconds;
+  }
+  return best;
+}
+
+// four times the text must take about four times as long; a lexer that rescans to the end of
+// the line at every token takes sixteen times as long, so twice the linear ratio is the limit
+static void checkLinear(LexerEngine engine, const char *name)
+{
+  const size_t STATEMENTS = 50000;
+  const size_t TOKENS_PER_STATEMENT = 8;
+  std::string small = makeLongLine(STATEMENTS);
+  std::string large = makeLongLine(4 * STATEMENTS);
+
+  double smallSeconds = timeLexing(small, engine, STATEMENTS * TOKENS_PER_STATEMENT);
+  double largeSeconds = timeLexing(large, engine, 4 * STATEMENTS * TOKENS_PER_STATEMENT);
+  double ratio = largeSeconds / smallSeconds;
+  printf("%s: %.1f KB in %.4f s, %.1f KB in %.4f s, ratio %.2f\n", name, small.size() / 1024.0, smallSeconds,
+    large.size() / 1024.0, largeSeconds, ratio);
+  CHECK(ratio < 8);
+}
+
+int main()
+{
+  checkLinear(TABLE_DRIVEN, "table driven");
+  checkLinear(MATCHER_CASCADE, "matcher cascade");
+  return finishChecks();
+}
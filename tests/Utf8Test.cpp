@@ -0,0 +1,122 @@
+#include <cstdio>
+#include <string>
+#include <random>
+#include "CharScan.h"
+#include "Check.h"
+
+using namespace lex;
+
+// offset of the first byte that isn't well-formed UTF-8, from the table of well-formed byte
+// sequences in the Unicode standard (table 3-7), or the length of the text
+static size_t findInvalid(const std::string &text)
+{
+  size_t i = 0;
+  while (i < text.size())
+  {
+    unsigned char b = text[i];
+    size_t length;
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    if (b < 0x80)
+      length = 1;
+    else if (b >= 0xC2 && b <= 0xDF)
+      length = 2;
+    else if (b >= 0xE0 && b <= 0xEF)
+    {
+      length = 3;
+      if (b == 0xE0)
+        low = 0xA0;
+      else if (b == 0xED)
+        high = 0x9F;
+    }
+    else if (b >= 0xF0 && b <= 0xF4)
+    {
+      length = 4;
+      if (b == 0xF0)
+        low = 0x90;
+      else if (b == 0xF4)
+        high = 0x8F;
+    }
+    else
+      return i;
+
+    if (i + length > text.size())
+      return i;
+    for (size_t j = 1; j < length; j++)
+    {
+      unsigned char c = text[i + j];
+      if (c < (j == 1 ? low : 0x80) || c > (j == 1 ? high : 0xBF))
+        return i;
+    }
+    i += length;
+  }
+  return text.size();
+}
+
+// every way findInvalidUtf8 may go finds the first bad byte the reference finds
+static bool sameAsReference(const std::string &text)
+{
+  const char *begin = text.data();
+  const char *end = begin + text.size();
+  size_t expected = findInvalid(text);
+  if (static_cast<size_t>(findInvalidUtf8Blocks(begin, end) - begin) != expected)
+    return false;
+  if (hasAvx2Utf8() && static_cast<size_t>(findInvalidUtf8Avx2(begin, end) - begin) != expected)
+    return false;
+  return static_cast<size_t>(findInvalidUtf8(begin, end) - begin) == expected;
+}
+
+// sequences on both sides of every limit of the table, at every place in and across the
+// 32-byte blocks of the AVX2 check
+static void checkLimits()
+{
+  static const char *const sequences[] =
+  {
+    "\x7F", "\x80", "\xBF", "\xC0\x80", "\xC1\xBF", "\xC2\x80", "\xDF\xBF", "\xC2", "\xC2\x7F", "\xC2\xC0",
+    "\xE0\x9F\xBF", "\xE0\xA0\x80", "\xE1\x80\x80", "\xEC\xBF\xBF", "\xED\x9F\xBF", "\xED\xA0\x80", "\xEE\x80\x80",
+    "\xEF\xBF\xBF", "\xE0\xA0", "\xE1\x80\x7F",
+    "\xF0\x8F\xBF\xBF", "\xF0\x90\x80\x80", "\xF3\xBF\xBF\xBF", "\xF4\x8F\xBF\xBF", "\xF4\x90\x80\x80", "\xF5\x80\x80\x80",
+    "\xF0\x90\x80", "\xF8\x88\x80\x80\x80", "\xFE", "\xFF"
+  };
+  for (size_t i = 0; i < sizeof(sequences) / sizeof(sequences[0]); i++)
+  {
+    for (size_t before = 0; before < 70; before++)
+    {
+      std::string text = std::string(before, 'a') + sequences[i];
+      if (!CHECK(sameAsReference(text)) || !CHECK(sameAsReference(text + "bc")) || !CHECK(sameAsReference(text + "\xC3\xA9 z")))
+        return;
+    }
+  }
+}
+
+// mostly valid text with a bad byte now and then, so the first error falls anywhere
+static void checkRandomText()
+{
+  static const char *const pieces[] =
+  {
+    "a", " ", "xyz0123456789", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xED\x9F\xBF", "\xF4\x8F\xBF\xBF",
+    "\x80", "\xC3", "\xE2\x82", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xC0\xAF"
+  };
+  const size_t PIECE_COUNT = sizeof(pieces) / sizeof(pieces[0]);
+  const size_t VALID_COUNT = 8;
+
+  std::mt19937 random(1);
+  for (int i = 0; i < 20000; i++)
+  {
+    std::string text;
+    size_t count = random() % 200;
+    for (size_t j = 0; j < count; j++)
+      text += pieces[(random() % 50 == 0) ? random() % PIECE_COUNT : random() % VALID_COUNT];
+    if (!CHECK(sameAsReference(text)))
+      return;
+  }
+}
+
+int main()
+{
+  if (!hasAvx2Utf8())
+    printf("no AVX2 on this CPU, only the portable check is tested\n");
+  checkLimits();
+  checkRandomText();
+  return finishChecks();
+}